@@ -0,0 +1,170 @@
+#include "BomCorpus.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QStringEncoder>
+#include <QStringList>
+
+namespace BomCorpus {
+namespace {
+const QStringList kBrands = {
+    QStringLiteral("UNI-ROYAL(厚声)"), QStringLiteral("YAGEO(国巨)"), QStringLiteral("Samsung(三星)"),
+    QStringLiteral("ST(意法半导体)"), QStringLiteral("TI(德州仪器)"), QStringLiteral("Murata(村田)"),
+    QStringLiteral("FH(风华)"), QStringLiteral("GigaDevice(兆易创新)")
+};
+const QStringList kPackages = {
+    QStringLiteral("0402"), QStringLiteral("0603"), QStringLiteral("0805"), QStringLiteral("SOT-23"),
+    QStringLiteral("SOP-8"), QStringLiteral("LQFP-48"), QStringLiteral("QFN-32")
+};
+const QStringList kNames = {
+    QStringLiteral("贴片电阻"), QStringLiteral("贴片电容"), QStringLiteral("肖特基二极管"),
+    QStringLiteral("MOS管"), QStringLiteral("单片机(MCU/MPU/SOC)"), QStringLiteral("LDO稳压器")
+};
+const QStringList kProjects = {
+    QStringLiteral("主控板"), QStringLiteral("电源板"), QStringLiteral("Sensor Hub"), QStringLiteral("驱动板")
+};
+
+const QString &pick(QRandomGenerator &rng, const QStringList &values)
+{
+    return values[rng.bounded(static_cast<int>(values.size()))];
+}
+
+// Encodes lines in ~1 MiB blocks so a million-row corpus never sits in memory as a whole.
+class LineSink
+{
+public:
+    LineSink(QFile *file, QStringEncoder *encoder)
+        : m_file(file)
+        , m_encoder(encoder)
+    {
+    }
+
+    bool add(const QString &line)
+    {
+        m_block += line;
+        m_block += QStringLiteral("\r\n");
+        return m_block.size() < (1 << 20) || flush();
+    }
+
+    bool flush()
+    {
+        const QByteArray bytes = m_encoder->encode(m_block);
+        m_block.resize(0);
+        return m_file->write(bytes) == bytes.size();
+    }
+
+private:
+    QFile *m_file = nullptr;
+    QStringEncoder *m_encoder = nullptr;
+    QString m_block;
+};
+
+QString quoted(const QString &text)
+{
+    return QLatin1Char('"') + QString(text).replace(QLatin1Char('"'), QStringLiteral("\"\"")) + QLatin1Char('"');
+}
+
+// Free-text cell exercising the CSV corner cases: quoted commas on most rows, an embedded
+// line break every 40th row and an escaped quote every 97th.
+QString description(QRandomGenerator &rng, int row)
+{
+    QString text = QStringLiteral("%1 %2, ±%3%")
+                       .arg(pick(rng, kNames))
+                       .arg(rng.bounded(1, 1000))
+                       .arg(rng.bounded(1, 10));
+    if (row % 40 == 0) {
+        text += QStringLiteral("\n备注: 替代料可选");
+    }
+    if (row % 97 == 0) {
+        text += QStringLiteral(" \"X7R\"");
+    }
+    return quoted(text);
+}
+
+QString price(QRandomGenerator &rng)
+{
+    return QString::number(rng.bounded(1, 500000) / 10000.0, 'f', 4);
+}
+
+bool writeLichuang(const Spec &spec, LineSink &sink)
+{
+    QRandomGenerator rng(quint32(spec.rows) * 31u + 7u);
+    bool ok = sink.add(QStringLiteral("立创商城 订单明细,,,,,,,,,,"))
+        && sink.add(QStringLiteral("订单编号：SO2026%1,,,,,,,,,,").arg(spec.rows, 8, 10, QLatin1Char('0')))
+        && sink.add(QStringLiteral(",,,,,,,,,,"))
+        && sink.add(QStringLiteral("序号,商品编号,品牌,厂家型号,封装,商品名称,订购数量（修改后）,最小包装,库存,商品单价,商品金额"));
+
+    for (int i = 1; ok && i <= spec.rows; ++i) {
+        const int qty = rng.bounded(1, 5000);
+        const QString unitPrice = price(rng);
+        ok = sink.add(QStringList{
+            QString::number(i),
+            QStringLiteral("C%1").arg(rng.bounded(1000, 9999999)),
+            quoted(pick(rng, kBrands)),
+            QStringLiteral("MPN-%1-%2").arg(rng.bounded(100000)).arg(pick(rng, kPackages)),
+            pick(rng, kPackages),
+            description(rng, i),
+            QString::number(qty),
+            QString::number(rng.bounded(1, 50) * 100),
+            QString::number(rng.bounded(100000)),
+            unitPrice,
+            QString::number(qty * unitPrice.toDouble(), 'f', 4),
+        }.join(QLatin1Char(',')));
+    }
+    return ok;
+}
+
+bool writeGeneric(const Spec &spec, LineSink &sink)
+{
+    QRandomGenerator rng(quint32(spec.rows) * 17u + 3u);
+    bool ok = sink.add(QStringLiteral("项目,位号,型号,封装,数量,描述,单价,备注"));
+
+    for (int i = 1; ok && i <= spec.rows; ++i) {
+        ok = sink.add(QStringList{
+            pick(rng, kProjects),
+            quoted(QStringLiteral("R%1,R%2").arg(i).arg(i + 1)),
+            QStringLiteral("MPN-%1").arg(rng.bounded(100000)),
+            pick(rng, kPackages),
+            QString::number(rng.bounded(1, 200)),
+            description(rng, i),
+            price(rng),
+            (i % 11 == 0) ? QString() : QStringLiteral("批次%1").arg(rng.bounded(100)),
+        }.join(QLatin1Char(',')));
+    }
+    return ok;
+}
+} // namespace
+
+QString name(const Spec &spec)
+{
+    return QStringLiteral("%1-%2-%3")
+        .arg(spec.layout == Layout::Lichuang ? QStringLiteral("lichuang") : QStringLiteral("generic"),
+             spec.encoding == Encoding::Utf8 ? QStringLiteral("utf8") : QStringLiteral("gbk"))
+        .arg(spec.rows);
+}
+
+qint64 write(const Spec &spec, const QString &path, QString *error)
+{
+    QStringEncoder encoder = spec.encoding == Encoding::Utf8 ? QStringEncoder(QStringEncoder::Utf8)
+                                                             : QStringEncoder("GB18030");
+    if (!encoder.isValid()) {
+        *error = QStringLiteral("GB18030 codec is not available in this Qt build.");
+        return -1;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = QStringLiteral("Cannot write corpus file: %1").arg(path);
+        return -1;
+    }
+
+    LineSink sink(&file, &encoder);
+    const bool written = spec.layout == Layout::Lichuang ? writeLichuang(spec, sink) : writeGeneric(spec, sink);
+    if (!written || !sink.flush()) {
+        *error = QStringLiteral("Write failed: %1").arg(path);
+        return -1;
+    }
+    return file.size();
+}
+
+} // namespace BomCorpus
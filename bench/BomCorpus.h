@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QString>
+
+// Deterministic synthetic BOM exports for the import benchmark. The same spec always
+// produces byte-identical files, so throughput numbers stay comparable between releases.
+namespace BomCorpus {
+
+enum class Layout {
+    Lichuang,
+    Generic
+};
+
+enum class Encoding {
+    Utf8,
+    Gbk
+};
+
+struct Spec {
+    Layout layout = Layout::Lichuang;
+    Encoding encoding = Encoding::Utf8;
+    int rows = 1000;
+};
+
+QString name(const Spec &spec);
+
+// Writes the corpus to path; returns the file size, or -1 with error set.
+qint64 write(const Spec &spec, const QString &path, QString *error);
+
+} // namespace BomCorpus
@@ -0,0 +1,344 @@
+#include "AppLogger.h"
+#include "BomCorpus.h"
+#include "CsvParallelParser.h"
+#include "CsvParsers.h"
+#include "CsvRecordReader.h"
+#include "ImportCache.h"
+#include "ImportService.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+// Process-wide high-water mark, so each result reports the peak reached so far.
+qint64 peakRssBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+    }
+    return -1;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(Q_OS_MACOS)
+    return static_cast<qint64>(usage.ru_maxrss);
+#else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+struct Corpus {
+    BomCorpus::Spec spec;
+    QString path;
+    qint64 bytes = 0;
+};
+
+class Bench
+{
+public:
+    explicit Bench(int repeat)
+        : m_repeat(qMax(1, repeat))
+    {
+    }
+
+    // Runs body m_repeat times and records the fastest pass; body returns the parsed row count.
+    void run(const Corpus &corpus, const QString &stage, const QJsonObject &extra, const std::function<qint64()> &body)
+    {
+        qint64 best = -1;
+        qint64 rows = 0;
+        for (int i = 0; i < m_repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            rows = body();
+            const qint64 elapsed = timer.nsecsElapsed();
+            if (best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+
+        const double seconds = qMax<qint64>(1, best) / 1e9;
+        QJsonObject result = extra;
+        result.insert(QStringLiteral("corpus"), BomCorpus::name(corpus.spec));
+        result.insert(QStringLiteral("stage"), stage);
+        result.insert(QStringLiteral("generatedRows"), corpus.spec.rows);
+        result.insert(QStringLiteral("parsedRows"), rows);
+        result.insert(QStringLiteral("bytes"), corpus.bytes);
+        result.insert(QStringLiteral("seconds"), seconds);
+        result.insert(QStringLiteral("mbPerSec"), corpus.bytes / seconds / (1024.0 * 1024.0));
+        result.insert(QStringLiteral("rowsPerSec"), rows / seconds);
+        result.insert(QStringLiteral("peakRssBytes"), peakRssBytes());
+        m_results.append(result);
+
+        std::fprintf(stderr, "%-28s %-18s %10.2f MB/s %12.0f rows/s\n",
+                     qPrintable(BomCorpus::name(corpus.spec)), qPrintable(stage),
+                     result.value(QStringLiteral("mbPerSec")).toDouble(),
+                     result.value(QStringLiteral("rowsPerSec")).toDouble());
+    }
+
+    QJsonArray results() const { return m_results; }
+
+private:
+    int m_repeat = 1;
+    QJsonArray m_results;
+};
+
+// The line splitter imports used before the block scanner, kept as the sweep's baseline.
+QStringList parseCsvLine(const QString &line)
+{
+    QStringList result;
+    QString current;
+    bool inQuotes = false;
+
+    for (int i = 0; i < line.size(); ++i) {
+        const QChar ch = line[i];
+        if (ch == '"') {
+            if (inQuotes && i + 1 < line.size() && line[i + 1] == '"') {
+                current.append('"');
+                ++i;
+            } else {
+                inQuotes = !inQuotes;
+            }
+        } else if (ch == ',' && !inQuotes) {
+            result.append(current);
+            current.clear();
+        } else {
+            current.append(ch);
+        }
+    }
+
+    result.append(current);
+    return result;
+}
+
+// Raw record scan (no decoding) with every block kernel the CPU supports, after the old
+// whole-file decode and per-line split they replace. The baseline decodes every field, so it
+// is an upper bound on what the old path spent on scanning alone.
+void benchKernels(Bench &bench, const Corpus &corpus)
+{
+    bench.run(corpus, QStringLiteral("scan"), {{QStringLiteral("kernel"), QStringLiteral("baseline")}}, [&]() -> qint64 {
+        QFile file(corpus.path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return 0;
+        }
+        const QStringList lines = QString::fromUtf8(file.readAll()).split(QRegularExpression(QStringLiteral("\\r?\\n")));
+        qint64 records = 0;
+        for (const QString &line : lines) {
+            if (!line.isEmpty() && !parseCsvLine(line).isEmpty()) {
+                ++records;
+            }
+        }
+        return records;
+    });
+
+    QList<CsvScanner::Kernel> kernels = {CsvScanner::Kernel::Scalar};
+    if (CsvScanner::bestKernel() != CsvScanner::Kernel::Scalar) {
+        kernels.append(CsvScanner::Kernel::Sse2);
+    }
+    if (CsvScanner::bestKernel() == CsvScanner::Kernel::Avx2) {
+        kernels.append(CsvScanner::Kernel::Avx2);
+    }
+
+    for (const CsvScanner::Kernel kernel : kernels) {
+        const QJsonObject extra = {{QStringLiteral("kernel"), QString::fromLatin1(CsvScanner::kernelName(kernel))}};
+        bench.run(corpus, QStringLiteral("scan"), extra, [&]() -> qint64 {
+            QFile file(corpus.path);
+            if (!file.open(QIODevice::ReadOnly)) {
+                return 0;
+            }
+            CsvRecordReader reader(&file);
+            reader.setScanKernel(kernel);
+            while (reader.next()) {
+            }
+            return reader.recordCount();
+        });
+    }
+}
+
+// Full record decoding through CsvParallelParser at 1, 2, 4, ... pool threads.
+void benchThreads(Bench &bench, const Corpus &corpus)
+{
+    QFile file(corpus.path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const uchar *data = file.map(0, file.size());
+    if (!data) {
+        return;
+    }
+    const QByteArrayView body(reinterpret_cast<const char *>(data), file.size());
+    const CsvRecordReader::Encoding encoding
+        = CsvRecordReader::detectEncoding(body.first(qMin<qsizetype>(body.size(), CsvRecordReader::SniffWindowSize)));
+    const CsvParallelParser::RowBuilder buildRow = [](const CsvRecordReader &record, QStringList *row) {
+        *row = record.fields();
+        return true;
+    };
+
+    const int maxThreads = qMax(1, QThread::idealThreadCount());
+    for (int threads = 1;; threads = qMin(threads * 2, maxThreads)) {
+        const QJsonObject extra = {{QStringLiteral("threads"), threads}};
+        bench.run(corpus, QStringLiteral("parallel"), extra, [&]() -> qint64 {
+            return CsvParallelParser(encoding, threads).parseRows(body, buildRow).size();
+        });
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+}
+
+void benchCorpus(Bench &bench, const Corpus &corpus, bool sweeps)
+{
+    const QString project = QStringLiteral("Bench");
+    const bool lichuang = corpus.spec.layout == BomCorpus::Layout::Lichuang;
+
+    bench.run(corpus, QStringLiteral("parser"), {}, [&]() -> qint64 {
+        const ImportResult result = lichuang ? LichuangCsvParser().parseFile(corpus.path, project)
+                                             : GenericCsvParser().parseFile(corpus.path, project);
+        return result.ok ? result.rows.size() : -1;
+    });
+
+    bench.run(corpus, QStringLiteral("service"), {}, [&]() -> qint64 {
+        const ImportService service;
+        const ImportResult result = lichuang ? service.importLichuangSpreadsheet(corpus.path, project)
+                                             : service.importGenericSpreadsheet(corpus.path, project);
+        return result.ok ? result.rows.size() : -1;
+    });
+
+    // Repeat import of an unchanged file; the entry is written up front so every pass is a hit.
+    ImportCache cache(QFileInfo(corpus.path).dir().filePath(QStringLiteral("import_cache")));
+    cache.setMaxBytes(std::numeric_limits<qint64>::max());
+    ImportService cachedService;
+    cachedService.setCache(&cache);
+    const auto cachedImport = [&]() -> qint64 {
+        const ImportResult result = lichuang ? cachedService.importLichuangSpreadsheet(corpus.path, project)
+                                             : cachedService.importGenericSpreadsheet(corpus.path, project);
+        return result.ok ? result.rows.size() : -1;
+    };
+    cachedImport();
+    bench.run(corpus, QStringLiteral("service-cached"), {}, cachedImport);
+
+    if (sweeps) {
+        benchKernels(bench, corpus);
+        benchThreads(bench, corpus);
+    }
+}
+
+QList<int> parseRowCounts(const QString &text)
+{
+    QList<int> counts;
+    for (const QString &part : text.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int value = part.trimmed().toInt(&ok);
+        if (ok && value > 0) {
+            counts.append(value);
+        }
+    }
+    return counts;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("link2bom_bench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Link2BOM import throughput benchmark"));
+    parser.addHelpOption();
+    const QCommandLineOption rowsOption(QStringLiteral("rows"), QStringLiteral("Comma-separated corpus sizes."),
+                                        QStringLiteral("list"), QStringLiteral("1000,10000,100000,1000000"));
+    const QCommandLineOption repeatOption(QStringLiteral("repeat"), QStringLiteral("Passes per case; the fastest is kept."),
+                                          QStringLiteral("n"), QStringLiteral("3"));
+    const QCommandLineOption outputOption(QStringLiteral("output"), QStringLiteral("Write the JSON report to this file instead of stdout."),
+                                          QStringLiteral("file"));
+    const QCommandLineOption workDirOption(QStringLiteral("work-dir"), QStringLiteral("Keep generated corpora in this directory."),
+                                           QStringLiteral("dir"));
+    parser.addOptions({rowsOption, repeatOption, outputOption, workDirOption});
+    parser.process(app);
+
+    // The import path logs every request; keep stdout for the report.
+    AppLogger::initialize();
+    spdlog::set_level(spdlog::level::warn);
+
+    QTemporaryDir tempDir;
+    const QString workDir = parser.isSet(workDirOption) ? parser.value(workDirOption) : tempDir.path();
+    if (workDir.isEmpty() || !QDir().mkpath(workDir)) {
+        std::fprintf(stderr, "Cannot create work directory.\n");
+        return 1;
+    }
+
+    const QList<int> rowCounts = parseRowCounts(parser.value(rowsOption));
+    Bench bench(parser.value(repeatOption).toInt());
+
+    for (const int rows : rowCounts) {
+        const QList<BomCorpus::Spec> specs = {
+            {BomCorpus::Layout::Lichuang, BomCorpus::Encoding::Utf8, rows},
+            {BomCorpus::Layout::Lichuang, BomCorpus::Encoding::Gbk, rows},
+            {BomCorpus::Layout::Generic, BomCorpus::Encoding::Utf8, rows},
+            {BomCorpus::Layout::Generic, BomCorpus::Encoding::Gbk, rows},
+        };
+        for (const BomCorpus::Spec &spec : specs) {
+            Corpus corpus;
+            corpus.spec = spec;
+            corpus.path = QDir(workDir).filePath(BomCorpus::name(spec) + QStringLiteral(".csv"));
+            QString error;
+            corpus.bytes = BomCorpus::write(spec, corpus.path, &error);
+            if (corpus.bytes < 0) {
+                std::fprintf(stderr, "%s\n", qPrintable(error));
+                continue;
+            }
+            // Kernel and thread sweeps need only one layout per size.
+            const bool sweeps = spec.layout == BomCorpus::Layout::Lichuang && spec.encoding == BomCorpus::Encoding::Utf8;
+            benchCorpus(bench, corpus, sweeps);
+        }
+    }
+
+    QJsonObject report;
+    report.insert(QStringLiteral("benchmark"), QStringLiteral("link2bom_bench"));
+    report.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.insert(QStringLiteral("qtVersion"), QString::fromLatin1(qVersion()));
+    report.insert(QStringLiteral("scanKernel"), QString::fromLatin1(CsvScanner::kernelName(CsvScanner::bestKernel())));
+    report.insert(QStringLiteral("idealThreadCount"), QThread::idealThreadCount());
+    report.insert(QStringLiteral("repeat"), qMax(1, parser.value(repeatOption).toInt()));
+    report.insert(QStringLiteral("results"), bench.results());
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile out(parser.value(outputOption));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(json) != json.size()) {
+            std::fprintf(stderr, "Cannot write report: %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+    return 0;
+}
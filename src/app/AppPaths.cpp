@@ -0,0 +1,86 @@
+#include "AppPaths.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QMutex>
+#include <QStandardPaths>
+
+#include <utility>
+
+namespace {
+QString scratchRoot()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation))
+        .filePath(QStringLiteral("link2bom_scratch"));
+}
+} // namespace
+
+namespace AppPaths {
+
+QString dataDir()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    }
+    const QString appName = QCoreApplication::applicationName().trimmed();
+    if (!appName.isEmpty()) {
+        QString clean = QDir::cleanPath(dir);
+        const QString doubleSuffix = QLatin1Char('/') + appName + QLatin1Char('/') + appName;
+        if (clean.endsWith(doubleSuffix)) {
+            clean = clean.left(clean.size() - appName.size() - 1);
+        }
+        dir = clean;
+    }
+    return dir;
+}
+
+// Each process owns <root>/<pid> and holds <root>/<pid>.lock for as long as it runs. The lock
+// is taken before the directory is made, so a directory without a held lock is stale.
+QString scratchDir()
+{
+    static QMutex mutex;
+    static QLockFile *lock = nullptr;
+    static QString dir;
+
+    const QMutexLocker locker(&mutex);
+    if (!lock) {
+        const QString name = QString::number(QCoreApplication::applicationPid());
+        const QDir root(scratchRoot());
+        root.mkpath(QStringLiteral("."));
+        lock = new QLockFile(root.filePath(name + QStringLiteral(".lock")));
+        lock->setStaleLockTime(0);
+        lock->tryLock(0);
+        dir = root.filePath(name);
+    }
+    QDir().mkpath(dir);
+    return dir;
+}
+
+void removeStaleScratchDirs()
+{
+    const QDir root(scratchRoot());
+    const QString own = QString::number(QCoreApplication::applicationPid());
+    QStringList names = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    const QStringList locks = root.entryList({QStringLiteral("*.lock")}, QDir::Files);
+    for (const QString &lock : locks) {
+        names.append(QFileInfo(lock).completeBaseName());
+    }
+    names.removeDuplicates();
+    for (const QString &name : std::as_const(names)) {
+        if (name == own) {
+            continue;
+        }
+        // A lock whose owner died is taken over here (and removed again on unlock); a live
+        // owner keeps it.
+        QLockFile lock(root.filePath(name + QStringLiteral(".lock")));
+        lock.setStaleLockTime(0);
+        if (lock.tryLock(0)) {
+            QDir(root.filePath(name)).removeRecursively();
+        }
+    }
+}
+
+} // namespace AppPaths
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QString>
+
+namespace AppPaths {
+
+// Per-user data root that holds saves/, the import cache and other app-owned files.
+QString dataDir();
+
+// Scratch directory owned by this process (under the system temp location), created on
+// first use. Conversion outputs live here; it is never cleaned while the process runs.
+QString scratchDir();
+
+// Deletes scratch directories whose owning process is gone. Call once at startup.
+void removeStaleScratchDirs();
+
+} // namespace AppPaths
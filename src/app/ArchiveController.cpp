@@ -1,8 +1,10 @@
 ﻿#include "ArchiveController.h"
 
+#include "AppPaths.h"
 #include "ProjectController.h"
 #include "CategoryController.h"
 #include "BomTableModel.h"
+#include "StringPool.h"
 
 #include <QDateTime>
 #include <QFileInfo>
@@ -11,8 +13,6 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QCoreApplication>
-#include <QStandardPaths>
 #include <QRegularExpression>
 
 namespace {
@@ -95,20 +95,7 @@ ArchiveController::ArchiveController(ProjectController *projects,
 
 QString ArchiveController::baseDir() const
 {
-    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
-    if (dir.isEmpty()) {
-        dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    }
-    const QString appName = QCoreApplication::applicationName().trimmed();
-    if (!appName.isEmpty()) {
-        QString clean = QDir::cleanPath(dir);
-        const QString doubleSuffix = QLatin1Char('/') + appName + QLatin1Char('/') + appName;
-        if (clean.endsWith(doubleSuffix)) {
-            clean = clean.left(clean.size() - appName.size() - 1);
-        }
-        dir = clean;
-    }
-    return QDir(dir).filePath(QStringLiteral("saves"));
+    return QDir(AppPaths::dataDir()).filePath(QStringLiteral("saves"));
 }
 
 QString ArchiveController::registryPath() const
@@ -188,6 +175,8 @@ QJsonArray ArchiveController::writeRows(const QVariantList &rows) const
 
 QVariantList ArchiveController::readRows(const QJsonArray &rows) const
 {
+    // Equal cells share one string until the model interns them.
+    StringPool pool;
     QVariantList list;
     list.reserve(rows.size());
     for (const QJsonValue &rowValue : rows) {
@@ -195,7 +184,7 @@ QVariantList ArchiveController::readRows(const QJsonArray &rows) const
         QStringList row;
         row.reserve(rowArray.size());
         for (const QJsonValue &cell : rowArray) {
-            row.append(cell.toString());
+            row.append(pool.share(cell.toString()));
         }
         list.append(row);
     }
@@ -1,12 +1,25 @@
 ﻿#include "BomTableModel.h"
+#include "HeaderMatcher.h"
 
 #include <QHash>
-#include <QRegularExpression>
 #include <QSet>
 #include <QVariantMap>
+#include <QtConcurrent/QtConcurrentRun>
 #include <algorithm>
+#include <iterator>
+#include <numeric>
 
 namespace {
+// Below this many distinct strings a plain scan answers a keyword quickly enough.
+constexpr int KeywordIndexMinStrings = 4096;
+// Keyword results kept for backspacing through recent keywords.
+constexpr int FilterCacheSize = 8;
+// Below this many stored rows the view is filtered and sorted in place, sooner than a round
+// trip through the thread pool would finish.
+constexpr int BackgroundViewMinRows = 20000;
+// Rows filtered between checks for a newer view request.
+constexpr int StaleCheckInterval = 16384;
+
 int findSourceColumnByAliases(const QStringList &headers, const QStringList &aliases, int fallback = -1)
 {
     for (int i = 0; i < headers.size(); ++i) {
@@ -20,16 +33,54 @@ int findSourceColumnByAliases(const QStringList &headers, const QStringList &ali
     }
     return fallback;
 }
+
+int numericFieldFromName(const QString &name)
+{
+    const QString key = name.trimmed().toLower();
+    if (key == QStringLiteral("qty") || key == QStringLiteral("quantity")) {
+        return BomTableModel::Quantity;
+    }
+    if (key == QStringLiteral("unitprice") || key == QStringLiteral("price")) {
+        return BomTableModel::UnitPrice;
+    }
+    if (key == QStringLiteral("amount")) {
+        return BomTableModel::Amount;
+    }
+    return -1;
+}
+
+FixedDecimal rangeBound(const QVariant &bound)
+{
+    if (!bound.isValid() || bound.isNull()) {
+        return {};
+    }
+    return FixedDecimal::fromText(bound.toString());
+}
+
+QStringList sortedValues(const StringPool &pool, const QSet<quint32> &ids)
+{
+    QStringList values;
+    values.reserve(ids.size());
+    for (const quint32 id : ids) {
+        values.append(pool.string(id));
+    }
+    std::sort(values.begin(), values.end(), [](const QString &a, const QString &b) {
+        return QString::localeAwareCompare(a, b) < 0;
+    });
+    return values;
+}
 }
 
 BomTableModel::BomTableModel(QObject *parent)
     : QAbstractTableModel(parent)
 {
+    connect(&m_keywordIndexWatcher, &QFutureWatcher<TrigramIndex>::finished, this, &BomTableModel::adoptKeywordIndex);
+    connect(&m_viewWatcher, &QFutureWatcher<ViewResult>::finished, this, &BomTableModel::adoptView);
 }
 
 int BomTableModel::rowCount(const QModelIndex &parent) const
 {
-    return parent.isValid() ? 0 : m_filteredRows.size();
+    return parent.isValid() ? 0 : int(m_filteredRows.size());
 }
 
 int BomTableModel::columnCount(const QModelIndex &parent) const
@@ -39,13 +90,14 @@ int BomTableModel::columnCount(const QModelIndex &parent) const
 
 QVariant BomTableModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= m_filteredRows.size() || index.column() >= m_visibleSourceColumns.size()) {
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= rowCount() || index.column() >= m_visibleSourceColumns.size()) {
         return {};
     }
 
     const int sourceIndex = m_visibleSourceColumns[index.column()];
-    const QStringList &row = m_filteredRows[index.row()];
-    return (sourceIndex >= 0 && sourceIndex < row.size()) ? row[sourceIndex] : QVariant();
+    return (sourceIndex >= 0 && sourceIndex < m_data.table.columnCount())
+        ? m_data.table.cell(m_filteredRows[index.row()], sourceIndex)
+        : QVariant();
 }
 
 QVariant BomTableModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -89,8 +141,8 @@ void BomTableModel::setVisibleHeaderAt(int slot, const QString &header)
 
     m_visibleSourceColumns[slot] = sourceIndex;
     emit headerDataChanged(Qt::Horizontal, slot, slot);
-    if (!m_filteredRows.isEmpty()) {
-        emit dataChanged(index(0, slot), index(m_filteredRows.size() - 1, slot));
+    if (!m_filteredRows.empty()) {
+        emit dataChanged(index(0, slot), index(rowCount() - 1, slot));
     }
 }
 
@@ -106,13 +158,16 @@ void BomTableModel::sortByVisibleColumn(int slot, bool ascending)
     }
 
     const int sourceIndex = m_visibleSourceColumns[slot];
+    const int numericField = numericFieldOfColumn(sourceIndex);
 
-    std::sort(m_sourceRows.begin(), m_sourceRows.end(), [sourceIndex, ascending](const QStringList &a, const QStringList &b) {
-        const QString left = sourceIndex < a.size() ? a[sourceIndex] : QString();
-        const QString right = sourceIndex < b.size() ? b[sourceIndex] : QString();
-        return ascending ? left < right : left > right;
-    });
+    if (sourceIndex < 0 || sourceIndex >= m_data.table.columnCount()) {
+        return;
+    }
 
+    // Only the view order changes; the stored rows stay where they are. The sort runs with the
+    // view update below, on top of any still pending.
+    m_pendingSorts.append({sourceIndex, numericField, ascending});
+    ++m_rowsGeneration;
     rebuildFilteredRows();
 }
 
@@ -176,22 +231,15 @@ QStringList BomTableModel::distinctValuesByHeaderAliases(const QStringList &alia
         return {};
     }
 
-    QSet<QString> uniq;
-    for (const QStringList &row : m_filteredRows) {
-        if (sourceIndex >= row.size()) {
-            continue;
-        }
-        const QString value = row[sourceIndex].trimmed();
-        if (!value.isEmpty()) {
+    const StringPool &pool = m_data.table.pool();
+    QSet<quint32> uniq;
+    for (const int row : m_filteredRows) {
+        const quint32 value = pool.trimmedId(m_data.table.cellId(row, sourceIndex));
+        if (value != StringPool::EmptyId) {
             uniq.insert(value);
         }
     }
-
-    QStringList values = uniq.values();
-    std::sort(values.begin(), values.end(), [](const QString &a, const QString &b) {
-        return QString::localeAwareCompare(a, b) < 0;
-    });
-    return values;
+    return sortedValues(pool, uniq);
 }
 
 QString BomTableModel::filterKeyword() const
@@ -248,6 +296,26 @@ void BomTableModel::clearTypeFilter()
     setTypeFilter(QString());
 }
 
+void BomTableModel::setNumericRange(const QString &field, const QVariant &minimum, const QVariant &maximum)
+{
+    const int numericField = numericFieldFromName(field);
+    if (numericField < 0) {
+        return;
+    }
+
+    NumericRange &range = m_numericRanges[numericField];
+    range.minimum = rangeBound(minimum);
+    range.maximum = rangeBound(maximum);
+    range.active = range.minimum.isValid() || range.maximum.isValid();
+    rebuildFilteredRows();
+}
+
+void BomTableModel::clearNumericRanges()
+{
+    m_numericRanges = {};
+    rebuildFilteredRows();
+}
+
 void BomTableModel::removeRowsByProject(const QString &projectName)
 {
     const QString key = projectName.trimmed();
@@ -255,11 +323,21 @@ void BomTableModel::removeRowsByProject(const QString &projectName)
         return;
     }
 
+    const StringPool &pool = m_data.table.pool();
+    const quint32 projectId = pool.find(key);
+    if (projectId == StringPool::NoId || m_data.table.columnCount() == 0) {
+        return;
+    }
+    QList<int> kept;
+    kept.reserve(m_data.table.rowCount());
+    for (int row = 0; row < m_data.table.rowCount(); ++row) {
+        if (pool.trimmedId(m_data.table.cellId(row, 0)) != projectId) {
+            kept.append(row);
+        }
+    }
+
     beginResetModel();
-    auto endIt = std::remove_if(m_sourceRows.begin(), m_sourceRows.end(), [&key](const QStringList &row) {
-        return !row.isEmpty() && row.first().trimmed() == key;
-    });
-    m_sourceRows.erase(endIt, m_sourceRows.end());
+    keepSourceRows(kept);
     endResetModel();
 
     rebuildFilteredRows();
@@ -268,30 +346,12 @@ void BomTableModel::removeRowsByProject(const QString &projectName)
 QVariantList BomTableModel::analyzeDifferences(const QString &keyword, const QString &groupMode) const
 {
     QVariantList result;
-    if (m_sourceHeaders.isEmpty() || m_sourceRows.isEmpty()) {
+    if (m_sourceHeaders.isEmpty() || m_data.table.rowCount() == 0) {
         return result;
     }
 
-    const QString project = m_projectFilter.trimmed();
-    const QString typeFilterValue = m_typeFilter.trimmed();
-    const bool allProjects = project.isEmpty() || project.compare(QStringLiteral("All Projects"), Qt::CaseInsensitive) == 0;
-    const bool hasTypeFilter = !typeFilterValue.isEmpty();
-
-    QList<QStringList> scopedRows;
-    for (const QStringList &row : m_sourceRows) {
-        if (!allProjects) {
-            if (row.isEmpty() || row.first().trimmed() != project) {
-                continue;
-            }
-        }
-        if (hasTypeFilter) {
-            if (row.size() <= 5 || !row[5].contains(typeFilterValue, Qt::CaseInsensitive)) {
-                continue;
-            }
-        }
-        scopedRows.append(row);
-    }
-    if (scopedRows.isEmpty()) {
+    const QList<int> scoped = scopedRows();
+    if (scoped.isEmpty()) {
         return result;
     }
 
@@ -311,15 +371,12 @@ QVariantList BomTableModel::analyzeDifferences(const QString &keyword, const QSt
         return result;
     }
 
-    QHash<QString, QList<int>> groupRows;
-    for (int rowIndex = 0; rowIndex < scopedRows.size(); ++rowIndex) {
-        const QStringList &row = scopedRows[rowIndex];
-        if (keyColumn >= row.size()) {
-            continue;
-        }
-        const QString key = row[keyColumn].trimmed();
-        if (!key.isEmpty()) {
-            groupRows[key].append(rowIndex);
+    const StringPool &pool = m_data.table.pool();
+    QHash<quint32, QList<int>> groupRows;
+    for (const int row : scoped) {
+        const quint32 key = pool.trimmedId(m_data.table.cellId(row, keyColumn));
+        if (key != StringPool::EmptyId) {
+            groupRows[key].append(row);
         }
     }
 
@@ -347,22 +404,16 @@ QVariantList BomTableModel::analyzeDifferences(const QString &keyword, const QSt
             if (col == keyColumn || col == 0) {
                 continue;
             }
-            QSet<QString> uniq;
-            for (int idx : rows) {
-                const QStringList &r = scopedRows[idx];
-                if (col < r.size()) {
-                    const QString value = r[col].trimmed();
-                    if (!value.isEmpty()) {
-                        uniq.insert(value);
-                    }
+            QSet<quint32> uniq;
+            for (const int row : rows) {
+                const quint32 value = pool.trimmedId(m_data.table.cellId(row, col));
+                if (value != StringPool::EmptyId) {
+                    uniq.insert(value);
                 }
             }
             if (uniq.size() > 1) {
                 changedFields.append(m_sourceHeaders[col]);
-                QStringList values = uniq.values();
-                std::sort(values.begin(), values.end(), [](const QString &a, const QString &b) {
-                    return QString::localeAwareCompare(a, b) < 0;
-                });
+                const QStringList values = sortedValues(pool, uniq);
                 QVariantMap fieldItem;
                 fieldItem.insert(QStringLiteral("field"), m_sourceHeaders[col]);
                 fieldItem.insert(QStringLiteral("values"), QVariant::fromValue(values));
@@ -376,7 +427,7 @@ QVariantList BomTableModel::analyzeDifferences(const QString &keyword, const QSt
         }
 
         DiffEntry entry;
-        entry.key = it.key();
+        entry.key = pool.string(it.key());
         entry.rowCount = rows.size();
         entry.changedFieldCount = changedFields.size();
         entry.changedFields = changedFields.join(QStringLiteral(", "));
@@ -425,31 +476,12 @@ QVariantList BomTableModel::analyzeDifferences(const QString &keyword, const QSt
 QVariantMap BomTableModel::buildAnalytics(const QString &groupMode) const
 {
     QVariantMap out;
-    if (m_sourceHeaders.isEmpty() || m_sourceRows.isEmpty()) {
+    if (m_sourceHeaders.isEmpty() || m_data.table.rowCount() == 0) {
         return out;
     }
 
-    const QString project = m_projectFilter.trimmed();
-    const QString typeFilterValue = m_typeFilter.trimmed();
-    const bool allProjects = project.isEmpty() || project.compare(QStringLiteral("All Projects"), Qt::CaseInsensitive) == 0;
-    const bool hasTypeFilter = !typeFilterValue.isEmpty();
-
-    QList<QStringList> scopedRows;
-    scopedRows.reserve(m_sourceRows.size());
-    for (const QStringList &row : m_sourceRows) {
-        if (!allProjects) {
-            if (row.isEmpty() || row.first().trimmed() != project) {
-                continue;
-            }
-        }
-        if (hasTypeFilter) {
-            if (row.size() <= 5 || !row[5].contains(typeFilterValue, Qt::CaseInsensitive)) {
-                continue;
-            }
-        }
-        scopedRows.append(row);
-    }
-    if (scopedRows.isEmpty()) {
+    const QList<int> scoped = scopedRows();
+    if (scoped.isEmpty()) {
         return out;
     }
 
@@ -467,33 +499,39 @@ QVariantMap BomTableModel::buildAnalytics(const QString &groupMode) const
     }
 
     const int partColumn = findSourceColumnByAliases(m_sourceHeaders, {"part", "pn", "mpn", "item"}, 3);
+    // The quantity column is picked by header name, not by column role, so the health figures
+    // stay as they were (LCSC's headers match none of these names). Its side column is read
+    // when it has one.
     const int qtyColumn = findSourceColumnByAliases(m_sourceHeaders, {"qty", "quantity", "q'ty", "amount"}, -1);
+    int qtyField = -1;
+    for (int field = 0; field < NumericFieldCount; ++field) {
+        if (qtyColumn >= 0 && m_numericColumns[field] == qtyColumn) {
+            qtyField = field;
+        }
+    }
 
-    QHash<QString, int> groupCounts;
-    QHash<QString, int> partCounts;
-    QSet<QString> uniqueParts;
+    const StringPool &pool = m_data.table.pool();
+    QHash<quint32, int> groupCounts;
+    QHash<quint32, int> partCounts;
     int missingPartCount = 0;
     int lowQtyCount = 0;
 
-    const QRegularExpression nonNumeric(QStringLiteral("[^0-9.\\-]"));
-    for (const QStringList &row : scopedRows) {
-        const QString groupName = (groupColumn < row.size() ? row[groupColumn].trimmed() : QString());
-        groupCounts[groupName.isEmpty() ? QStringLiteral("(Empty)") : groupName] += 1;
+    for (const int row : scoped) {
+        groupCounts[pool.trimmedId(m_data.table.cellId(row, groupColumn))] += 1;
 
-        QString part = (partColumn >= 0 && partColumn < row.size()) ? row[partColumn].trimmed() : QString();
-        if (part.isEmpty()) {
+        const quint32 part = (partColumn >= 0 && partColumn < m_data.table.columnCount())
+            ? pool.trimmedId(m_data.table.cellId(row, partColumn))
+            : StringPool::EmptyId;
+        if (part == StringPool::EmptyId) {
             missingPartCount += 1;
         } else {
-            uniqueParts.insert(part);
             partCounts[part] += 1;
         }
 
-        if (qtyColumn >= 0 && qtyColumn < row.size()) {
-            QString qtyText = row[qtyColumn].trimmed();
-            qtyText.remove(nonNumeric);
-            bool ok = false;
-            const double qty = qtyText.toDouble(&ok);
-            if (ok && qty <= 1.0) {
+        if (qtyColumn >= 0) {
+            const FixedDecimal qty = qtyField >= 0 ? m_data.numbers[qtyField][row]
+                                                   : FixedDecimal::fromText(pool.string(m_data.table.cellId(row, qtyColumn)));
+            if (qty.isValid() && qty.raw() <= FixedDecimal::Scale) {
                 lowQtyCount += 1;
             }
         }
@@ -514,7 +552,7 @@ QVariantMap BomTableModel::buildAnalytics(const QString &groupMode) const
     sorted.reserve(groupCounts.size());
     for (auto it = groupCounts.cbegin(); it != groupCounts.cend(); ++it) {
         GroupItem item;
-        item.name = it.key();
+        item.name = it.key() == StringPool::EmptyId ? QStringLiteral("(Empty)") : pool.string(it.key());
         item.count = it.value();
         sorted.append(item);
     }
@@ -526,7 +564,7 @@ QVariantMap BomTableModel::buildAnalytics(const QString &groupMode) const
     });
 
     QVariantList groupItems;
-    const int total = scopedRows.size();
+    const int total = scoped.size();
     const int maxItems = 10;
     for (int i = 0; i < qMin(sorted.size(), maxItems); ++i) {
         QVariantMap item;
@@ -579,7 +617,7 @@ QVariantMap BomTableModel::buildAnalytics(const QString &groupMode) const
     out.insert(QStringLiteral("groupItems"), groupItems);
     out.insert(QStringLiteral("pieItems"), pieItems);
     out.insert(QStringLiteral("totalRows"), total);
-    out.insert(QStringLiteral("uniquePartCount"), uniqueParts.size());
+    out.insert(QStringLiteral("uniquePartCount"), partCounts.size());
     out.insert(QStringLiteral("lowQtyCount"), lowQtyCount);
     out.insert(QStringLiteral("missingPartCount"), missingPartCount);
     out.insert(QStringLiteral("duplicatePartCount"), duplicatePartCount);
@@ -593,9 +631,9 @@ QVariantMap BomTableModel::exportSnapshot() const
     QVariantMap snapshot;
     snapshot.insert(QStringLiteral("headers"), m_sourceHeaders);
     QVariantList rows;
-    rows.reserve(m_sourceRows.size());
-    for (const QStringList &row : m_sourceRows) {
-        rows.append(row);
+    rows.reserve(m_data.table.rowCount());
+    for (int row = 0; row < m_data.table.rowCount(); ++row) {
+        rows.append(m_data.table.row(row));
     }
     snapshot.insert(QStringLiteral("rows"), rows);
     return snapshot;
@@ -619,11 +657,20 @@ bool BomTableModel::importSnapshot(const QVariantMap &snapshot)
     return true;
 }
 
-void BomTableModel::setSourceData(const QStringList &headers, const QList<QStringList> &rows)
+void BomTableModel::setSourceData(const QStringList &headers, const QList<QStringList> &rows, const QList<int> &numericColumns)
 {
     beginResetModel();
     m_sourceHeaders = headers;
-    m_sourceRows = rows;
+    resolveNumericColumns(numericColumns);
+    m_data.table.reset(m_sourceHeaders.size());
+    m_data.numbers = {};
+    m_data.sortOrder.clear();
+    m_pendingSorts.clear();
+    m_filteredRows.clear();
+    m_data.keywordIndex.clear();
+    m_data.keywordIndexReady = false;
+    ++m_poolGeneration;
+    appendSourceRows(rows);
     m_visibleSourceColumns.clear();
     for (int i = 0; i < qMin(6, m_sourceHeaders.size()); ++i) {
         m_visibleSourceColumns.append(i);
@@ -633,14 +680,14 @@ void BomTableModel::setSourceData(const QStringList &headers, const QList<QStrin
     rebuildFilteredRows();
 }
 
-bool BomTableModel::appendRows(const QStringList &headers, const QList<QStringList> &rows)
+bool BomTableModel::appendRows(const QStringList &headers, const QList<QStringList> &rows, const QList<int> &numericColumns)
 {
     if (headers.isEmpty()) {
         return false;
     }
 
     if (m_sourceHeaders.isEmpty()) {
-        setSourceData(headers, rows);
+        setSourceData(headers, rows, numericColumns);
         return true;
     }
 
@@ -648,68 +695,447 @@ bool BomTableModel::appendRows(const QStringList &headers, const QList<QStringLi
         return false;
     }
 
+    // Stored rows are only added, so the view stays valid until the update below adds them.
+    appendSourceRows(rows);
+    rebuildFilteredRows();
+    return true;
+}
+
+void BomTableModel::replaceRows(const QList<QStringList> &removed, const QList<QStringList> &added)
+{
+    if (removed.isEmpty() && added.isEmpty()) {
+        return;
+    }
+
+    // Rows are compared as the ids the table would store them under; a removed row holding a
+    // string the pool never saw cannot be stored. Only stored rows whose first cell starts one
+    // of the removed rows have their ids gathered to look them up.
+    const StringPool &pool = m_data.table.pool();
+    const int width = m_data.table.columnCount();
+    QHash<QList<quint32>, int> pending;
+    QSet<quint32> firstIds;
+    for (const QStringList &row : removed) {
+        QList<quint32> ids(width, StringPool::EmptyId);
+        for (int i = 0; i < qMin(width, int(row.size())); ++i) {
+            ids[i] = pool.find(row[i]);
+        }
+        if (width > 0 && !ids.contains(StringPool::NoId)) {
+            firstIds.insert(ids.first());
+            pending[ids] += 1;
+        }
+    }
+
     beginResetModel();
-    for (const QStringList &row : rows) {
-        m_sourceRows.append(row);
+    if (!pending.isEmpty()) {
+        QList<int> kept;
+        kept.reserve(m_data.table.rowCount());
+        for (int row = 0; row < m_data.table.rowCount(); ++row) {
+            if (firstIds.contains(m_data.table.cellId(row, 0))) {
+                const auto it = pending.find(m_data.table.rowIds(row));
+                if (it != pending.end() && it.value() > 0) {
+                    it.value() -= 1;
+                    continue;
+                }
+            }
+            kept.append(row);
+        }
+        keepSourceRows(kept);
     }
+    appendSourceRows(added);
     endResetModel();
 
     rebuildFilteredRows();
-    return true;
 }
 
 void BomTableModel::rebuildFilteredRows()
 {
-    beginResetModel();
-    m_filteredRows.clear();
+    ViewRequest request;
+    request.generation = ++(*m_viewGeneration);
+    request.latestGeneration = m_viewGeneration;
+    request.base.rowsGeneration = m_rowsGeneration;
+    request.base.project = m_projectFilter.trimmed();
+    request.base.type = m_typeFilter.trimmed();
+    request.base.ranges = m_numericRanges;
+    request.keyword = m_filterKeyword.trimmed();
+
+    if (request.base == m_filterBase) {
+        const auto cached = std::find_if(m_filterCache.cbegin(), m_filterCache.cend(), [&request](const FilterCacheEntry &entry) {
+            return entry.keyword == request.keyword;
+        });
+        if (cached != m_filterCache.cend()) {
+            // Backspace, or a keyword seen shortly before: the earlier result is reused as it was.
+            ViewResult result;
+            result.generation = request.generation;
+            result.rows = cached->rows;
+            result.base = request.base;
+            result.keyword = request.keyword;
+            result.keyMatches = cached->keyMatches;
+            publishView(std::move(result));
+            return;
+        }
+        // Every row matching the keyword also matches the one already applied (one more
+        // character typed, say), so only the rows and strings matching that one are tested again.
+        if (request.keyword.contains(m_appliedKeyword, Qt::CaseInsensitive)) {
+            request.refine = true;
+            request.appliedKeyword = m_appliedKeyword;
+            request.appliedRows = m_filteredRows;
+            request.appliedKeyMatches = m_keyMatches;
+        }
+    }
+    request.data = m_data;
+    request.sorts = m_pendingSorts;
 
-    const QString key = m_filterKeyword.trimmed();
-    const QString project = m_projectFilter.trimmed();
-    const QString typeFilterValue = m_typeFilter.trimmed();
-    const bool hasTypeFilter = !typeFilterValue.isEmpty();
-    const bool allProjects = project.isEmpty()
-        || project.compare(QStringLiteral("All Projects"), Qt::CaseInsensitive) == 0;
+    if (m_data.table.rowCount() < BackgroundViewMinRows) {
+        publishView(computeView(request));
+        return;
+    }
+    // A job this replaces finishes unwatched, and sees the newer generation and stops early.
+    m_viewWatcher.setFuture(QtConcurrent::run([request = std::move(request)]() { return computeView(request); }));
+}
 
-    if (key.isEmpty()) {
-        if (allProjects) {
-            m_filteredRows = m_sourceRows;
-        } else {
-            for (const QStringList &row : m_sourceRows) {
-                if (!row.isEmpty() && row.first().trimmed() == project) {
-                    if (hasTypeFilter) {
-                        if (row.size() <= 5 || !row[5].contains(typeFilterValue, Qt::CaseInsensitive)) {
-                            continue;
-                        }
-                    }
-                    m_filteredRows.append(row);
-                }
-            }
+void BomTableModel::adoptView()
+{
+    ViewResult result = m_viewWatcher.result();
+    if (result.generation == m_viewGeneration->loadRelaxed()) {
+        publishView(std::move(result));
+    }
+}
+
+void BomTableModel::publishView(ViewResult result)
+{
+    // Columns stay as they are, so the view hears of moved rows rather than a reset and keeps
+    // its scroll position, as QSortFilterProxyModel::invalidate() does.
+    emit layoutAboutToBeChanged();
+    const QModelIndexList persistent = persistentIndexList();
+    QList<int> persistentRows;
+    persistentRows.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) {
+        persistentRows.append(m_filteredRows[index.row()]);
+    }
+
+    if (result.sorted) {
+        m_data.sortOrder = std::move(result.sortOrder);
+        m_pendingSorts.clear();
+    }
+    if (!(result.base == m_filterBase)) {
+        m_filterBase = result.base;
+        m_filterCache.clear();
+    }
+    m_filteredRows = std::move(result.rows);
+    m_appliedKeyword = result.keyword;
+    m_keyMatches = std::move(result.keyMatches);
+    m_filterCache.removeIf([this](const FilterCacheEntry &entry) { return entry.keyword == m_appliedKeyword; });
+    m_filterCache.prepend({m_appliedKeyword, m_filteredRows, m_keyMatches});
+    if (m_filterCache.size() > FilterCacheSize) {
+        m_filterCache.removeLast();
+    }
+
+    if (!persistent.isEmpty()) {
+        QHash<int, int> viewRows;
+        viewRows.reserve(qsizetype(m_filteredRows.size()));
+        for (int i = 0; i < int(m_filteredRows.size()); ++i) {
+            viewRows.insert(m_filteredRows[i], i);
         }
-    } else {
-        for (const QStringList &row : m_sourceRows) {
-            if (!allProjects) {
-                if (row.isEmpty() || row.first().trimmed() != project) {
-                    continue;
-                }
-            }
-            if (hasTypeFilter) {
-                if (row.size() <= 5 || !row[5].contains(typeFilterValue, Qt::CaseInsensitive)) {
-                    continue;
-                }
-            }
-            bool matched = false;
-            for (const QString &cell : row) {
-                if (cell.contains(key, Qt::CaseInsensitive)) {
-                    matched = true;
-                    break;
-                }
-            }
-            if (matched) {
-                m_filteredRows.append(row);
+        QModelIndexList moved;
+        moved.reserve(persistent.size());
+        for (int i = 0; i < persistent.size(); ++i) {
+            const int row = viewRows.value(persistentRows[i], -1);
+            moved.append(row >= 0 ? index(row, persistent[i].column()) : QModelIndex());
+        }
+        changePersistentIndexList(persistent, moved);
+    }
+    emit layoutChanged();
+}
+
+BomTableModel::ViewResult BomTableModel::computeView(const ViewRequest &request)
+{
+    const TableData &data = request.data;
+    const auto superseded = [&request]() { return request.latestGeneration->loadRelaxed() != request.generation; };
+    ViewResult result;
+    result.generation = request.generation;
+    result.base = request.base;
+    result.keyword = request.keyword;
+
+    // A superseded request stops early; its partial result is dropped on arrival anyway.
+    if (!request.sorts.isEmpty()) {
+        result.sorted = true;
+        result.sortOrder = data.sortOrder;
+        for (const SortKey &sort : request.sorts) {
+            if (superseded()) {
+                return result;
             }
+            applySort(data, sort, &result.sortOrder);
         }
     }
-    endResetModel();
+
+    if (request.refine) {
+        result.keyMatches = matchingIds(data, request.keyword,
+                                        request.appliedKeyword.isEmpty() ? nullptr : &request.appliedKeyMatches);
+        std::copy_if(request.appliedRows.cbegin(), request.appliedRows.cend(), std::back_inserter(result.rows),
+                     [&data, &result](int row) { return matchesKeyword(data, row, result.keyMatches); });
+        return result;
+    }
+
+    const Scope scope = resolveScope(data, request.base.project, request.base.type);
+    result.keyMatches = request.keyword.isEmpty() ? QList<bool>() : matchingIds(data, request.keyword);
+    const bool hasNumericRange = std::any_of(request.base.ranges.cbegin(), request.base.ranges.cend(), [](const NumericRange &range) {
+        return range.active;
+    });
+
+    // Walking the sort order yields matches already in view order.
+    const std::vector<int> &order = result.sorted ? result.sortOrder : data.sortOrder;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i % StaleCheckInterval == 0 && superseded()) {
+            return result;
+        }
+        const int row = order[i];
+        if (inScope(data, row, scope) && (!hasNumericRange || inNumericRanges(data, request.base.ranges, row))
+            && matchesKeyword(data, row, result.keyMatches)) {
+            result.rows.push_back(row);
+        }
+    }
+    return result;
+}
+
+void BomTableModel::applySort(const TableData &data, const SortKey &sort, std::vector<int> *order)
+{
+    // Sorting from the previous order keeps rows that compare equal in the order an earlier
+    // sort gave them.
+    const bool ascending = sort.ascending;
+    if (sort.numericField >= 0) {
+        const QList<FixedDecimal> &numbers = data.numbers[sort.numericField];
+        std::stable_sort(order->begin(), order->end(), [&numbers, ascending](int a, int b) {
+            return ascending ? numbers[a] < numbers[b] : numbers[b] < numbers[a];
+        });
+        return;
+    }
+
+    // Distinct strings are ranked once; rows then sort on the integer ranks of their ids.
+    const ColumnTable &table = data.table;
+    const StringPool &pool = table.pool();
+    QList<quint32> byText(pool.size());
+    std::iota(byText.begin(), byText.end(), 0u);
+    std::sort(byText.begin(), byText.end(), [&pool](quint32 a, quint32 b) { return pool.string(a) < pool.string(b); });
+    QList<int> rank(pool.size());
+    for (int i = 0; i < byText.size(); ++i) {
+        rank[byText[i]] = i;
+    }
+    const int column = sort.sourceColumn;
+    std::stable_sort(order->begin(), order->end(), [&table, &rank, column, ascending](int a, int b) {
+        const int left = rank[table.cellId(a, column)];
+        const int right = rank[table.cellId(b, column)];
+        return ascending ? left < right : right < left;
+    });
+}
+
+bool BomTableModel::matchesKeyword(const TableData &data, int row, const QList<bool> &keyMatches)
+{
+    if (keyMatches.isEmpty()) {
+        return true;
+    }
+    for (int column = 0; column < data.table.columnCount(); ++column) {
+        if (keyMatches[data.table.cellId(row, column)]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<bool> BomTableModel::matchingIds(const TableData &data, const QString &needle, const QList<bool> *within)
+{
+    const StringPool &pool = data.table.pool();
+    QList<bool> matches(pool.size());
+    std::vector<quint32> candidates;
+    if (data.keywordIndexReady && data.keywordIndex.candidates(needle, &candidates)) {
+        for (const quint32 id : candidates) {
+            matches[id] = (!within || (*within)[id]) && pool.string(id).contains(needle, Qt::CaseInsensitive);
+        }
+        return matches;
+    }
+    for (int id = 0; id < pool.size(); ++id) {
+        matches[id] = (!within || (*within)[id]) && pool.string(id).contains(needle, Qt::CaseInsensitive);
+    }
+    return matches;
+}
+
+BomTableModel::Scope BomTableModel::resolveScope(const TableData &data, const QString &project, const QString &type)
+{
+    Scope scope;
+    if (!project.isEmpty() && project.compare(QStringLiteral("All Projects"), Qt::CaseInsensitive) != 0) {
+        scope.allProjects = false;
+        scope.projectId = data.table.pool().find(project);
+    }
+    if (!type.isEmpty()) {
+        scope.typeMatches = matchingIds(data, type);
+    }
+    return scope;
+}
+
+// The view, analyzeDifferences and buildAnalytics all scope rows here, so the type filter
+// applies with or without a project or keyword.
+bool BomTableModel::inScope(const TableData &data, int row, const Scope &scope)
+{
+    const ColumnTable &table = data.table;
+    if (!scope.allProjects
+        && (table.columnCount() == 0 || table.pool().trimmedId(table.cellId(row, 0)) != scope.projectId)) {
+        return false;
+    }
+    return scope.typeMatches.isEmpty() || (table.columnCount() > 5 && scope.typeMatches[table.cellId(row, 5)]);
+}
+
+QList<int> BomTableModel::scopedRows() const
+{
+    const Scope scope = resolveScope(m_data, m_projectFilter.trimmed(), m_typeFilter.trimmed());
+    QList<int> rows;
+    for (int row = 0; row < m_data.table.rowCount(); ++row) {
+        if (inScope(m_data, row, scope)) {
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+void BomTableModel::resolveNumericColumns(const QList<int> &numericColumns)
+{
+    if (numericColumns.size() == NumericFieldCount) {
+        for (int field = 0; field < NumericFieldCount; ++field) {
+            const int column = numericColumns[field];
+            m_numericColumns[field] = column >= 0 && column < m_sourceHeaders.size() ? column : -1;
+        }
+        return;
+    }
+
+    // Snapshots and generic sheets carry no column roles; recognise them from the headers.
+    const HeaderMatcher &matcher = HeaderMatcher::lichuangColumns();
+    m_numericColumns[Quantity] = matcher.findColumn(m_sourceHeaders, HeaderMatcher::Qty,
+                                                    findSourceColumnByAliases(m_sourceHeaders, {"q'ty"}));
+    m_numericColumns[UnitPrice] = matcher.findColumn(m_sourceHeaders, HeaderMatcher::UnitPrice);
+    m_numericColumns[Amount] = matcher.findColumn(m_sourceHeaders, HeaderMatcher::Amount);
+}
+
+void BomTableModel::appendSourceRows(const QList<QStringList> &rows)
+{
+    m_data.table.reserve(m_data.table.rowCount() + rows.size());
+    for (QList<FixedDecimal> &numbers : m_data.numbers) {
+        numbers.reserve(m_data.table.rowCount() + rows.size());
+    }
+    m_data.sortOrder.reserve(m_data.table.rowCount() + rows.size());
+    ++m_rowsGeneration;
+    for (const QStringList &cells : rows) {
+        m_data.sortOrder.push_back(m_data.table.rowCount());
+        m_data.table.appendRow(cells);
+        for (int field = 0; field < NumericFieldCount; ++field) {
+            const int column = m_numericColumns[field];
+            m_data.numbers[field].append(column >= 0 && column < cells.size() ? FixedDecimal::fromText(cells[column])
+                                                                          : FixedDecimal());
+        }
+    }
+    refreshKeywordIndex();
 }
 
+void BomTableModel::refreshKeywordIndex()
+{
+    const StringPool &pool = m_data.table.pool();
+    if (m_data.keywordIndexReady) {
+        for (quint32 id = m_data.keywordIndex.indexedCount(); id < quint32(pool.size()); ++id) {
+            m_data.keywordIndex.add(id, pool.string(id));
+        }
+        return;
+    }
+    if (m_keywordIndexWatcher.isRunning() || pool.size() < KeywordIndexMinStrings) {
+        return;
+    }
+
+    // The worker gets its own copies of the strings (shallow ones), never the pool itself.
+    QStringList strings;
+    strings.reserve(pool.size());
+    for (int id = 0; id < pool.size(); ++id) {
+        strings.append(pool.string(id));
+    }
+    m_keywordIndexGeneration = m_poolGeneration;
+    m_keywordIndexWatcher.setFuture(QtConcurrent::run([strings = std::move(strings)]() {
+        TrigramIndex index;
+        for (int id = 0; id < strings.size(); ++id) {
+            index.add(quint32(id), strings[id]);
+        }
+        return index;
+    }));
+}
 
+void BomTableModel::adoptKeywordIndex()
+{
+    // A build whose ids were renumbered meanwhile is thrown away and started over.
+    if (m_keywordIndexGeneration == m_poolGeneration) {
+        m_data.keywordIndex = m_keywordIndexWatcher.result();
+        m_data.keywordIndexReady = true;
+    }
+    refreshKeywordIndex();
+}
+
+void BomTableModel::keepSourceRows(const QList<int> &rows)
+{
+    std::vector<int> renumbered(m_data.table.rowCount(), -1);
+    for (int i = 0; i < rows.size(); ++i) {
+        renumbered[rows[i]] = i;
+    }
+    auto out = m_data.sortOrder.begin();
+    for (const int row : m_data.sortOrder) {
+        if (renumbered[row] >= 0) {
+            *out++ = renumbered[row];
+        }
+    }
+    m_data.sortOrder.erase(out, m_data.sortOrder.end());
+    auto shown = m_filteredRows.begin();
+    for (const int row : m_filteredRows) {
+        if (renumbered[row] >= 0) {
+            *shown++ = renumbered[row];
+        }
+    }
+    m_filteredRows.erase(shown, m_filteredRows.end());
+    ++m_rowsGeneration;
+
+    QList<quint32> remap;
+    m_data.table.selectRows(rows, &remap);
+    if (!remap.isEmpty()) {
+        if (m_data.keywordIndexReady) {
+            m_data.keywordIndex.remap(remap);
+        } else {
+            ++m_poolGeneration;
+        }
+    }
+    for (QList<FixedDecimal> &numbers : m_data.numbers) {
+        QList<FixedDecimal> selected;
+        selected.reserve(rows.size());
+        for (const int row : rows) {
+            selected.append(numbers[row]);
+        }
+        numbers = std::move(selected);
+    }
+}
+
+int BomTableModel::numericFieldOfColumn(int sourceColumn) const
+{
+    for (int field = 0; field < NumericFieldCount; ++field) {
+        if (sourceColumn >= 0 && m_numericColumns[field] == sourceColumn) {
+            return field;
+        }
+    }
+    return -1;
+}
+
+bool BomTableModel::inNumericRanges(const TableData &data, const std::array<NumericRange, NumericFieldCount> &ranges, int row)
+{
+    for (int field = 0; field < NumericFieldCount; ++field) {
+        const NumericRange &range = ranges[field];
+        if (!range.active) {
+            continue;
+        }
+        const FixedDecimal &value = data.numbers[field][row];
+        if (!value.isValid()
+            || (range.minimum.isValid() && value < range.minimum)
+            || (range.maximum.isValid() && range.maximum < value)) {
+            return false;
+        }
+    }
+    return true;
+}
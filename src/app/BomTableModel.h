@@ -1,9 +1,19 @@
 ﻿#pragma once
 
 #include <QAbstractTableModel>
+#include <QAtomicInteger>
+#include <QFutureWatcher>
 #include <QVariantList>
 #include <QVariantMap>
 
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "ColumnTable.h"
+#include "FixedDecimal.h"
+#include "TrigramIndex.h"
+
 class BomTableModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -12,6 +22,14 @@ class BomTableModel : public QAbstractTableModel
     Q_PROPERTY(QString typeFilter READ typeFilter WRITE setTypeFilter NOTIFY typeFilterChanged)
 
 public:
+    // Columns kept as fixed-point side columns next to the text cells.
+    enum NumericField {
+        Quantity,
+        UnitPrice,
+        Amount,
+        NumericFieldCount
+    };
+
     explicit BomTableModel(QObject *parent = nullptr);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -35,14 +53,20 @@ public:
     QString typeFilter() const;
     Q_INVOKABLE void setTypeFilter(const QString &typeValue);
     Q_INVOKABLE void clearTypeFilter();
+    // field is "qty", "unitPrice" or "amount"; an empty bound leaves that side open.
+    Q_INVOKABLE void setNumericRange(const QString &field, const QVariant &minimum, const QVariant &maximum);
+    Q_INVOKABLE void clearNumericRanges();
     Q_INVOKABLE void removeRowsByProject(const QString &projectName);
     Q_INVOKABLE QVariantList analyzeDifferences(const QString &keyword, const QString &groupMode) const;
     Q_INVOKABLE QVariantMap buildAnalytics(const QString &groupMode) const;
     Q_INVOKABLE QVariantMap exportSnapshot() const;
     Q_INVOKABLE bool importSnapshot(const QVariantMap &snapshot);
 
-    void setSourceData(const QStringList &headers, const QList<QStringList> &rows);
-    Q_INVOKABLE bool appendRows(const QStringList &headers, const QList<QStringList> &rows);
+    // numericColumns is indexed by NumericField; when empty the columns are found from the headers.
+    void setSourceData(const QStringList &headers, const QList<QStringList> &rows, const QList<int> &numericColumns = {});
+    Q_INVOKABLE bool appendRows(const QStringList &headers, const QList<QStringList> &rows, const QList<int> &numericColumns = {});
+    // Drops one stored row equal to each entry of removed, then appends added.
+    void replaceRows(const QList<QStringList> &removed, const QList<QStringList> &added);
 
 signals:
     void filterKeywordChanged();
@@ -50,14 +74,152 @@ signals:
     void typeFilterChanged();
 
 private:
+    struct NumericRange {
+        bool active = false;
+        FixedDecimal minimum;
+        FixedDecimal maximum;
+
+        bool operator==(const NumericRange &other) const
+        {
+            return active == other.active && minimum == other.minimum && maximum == other.maximum;
+        }
+    };
+
+    // Everything besides the keyword that decides which rows the view shows, in which order.
+    // A keyword result is only reused or refined under the base it was computed under.
+    struct FilterBase {
+        quint64 rowsGeneration = 0;
+        QString project;
+        QString type;
+        std::array<NumericRange, NumericFieldCount> ranges;
+
+        bool operator==(const FilterBase &other) const
+        {
+            return rowsGeneration == other.rowsGeneration && project == other.project && type == other.type
+                && ranges == other.ranges;
+        }
+    };
+
+    struct FilterCacheEntry {
+        QString keyword;
+        std::vector<int> rows;
+        QList<bool> keyMatches;
+    };
+
+    // The project and type filters resolved against the string pool.
+    struct Scope {
+        bool allProjects = true;
+        quint32 projectId = StringPool::NoId;
+        // Per string id, whether it contains the type filter; empty without one.
+        QList<bool> typeMatches;
+    };
+
+    // A sort requested but not yet applied to the sort order.
+    struct SortKey {
+        int sourceColumn = -1;
+        int numericField = -1;
+        bool ascending = true;
+    };
+
+    // Everything filters and sorts read. Copies are cheap (all but the sort order is implicitly
+    // shared), so a view update on the thread pool works on its own snapshot while the live
+    // table keeps changing.
+    struct TableData {
+        ColumnTable table;
+        // Fixed-point side columns, indexed by NumericField and then by stored row.
+        std::array<QList<FixedDecimal>, NumericFieldCount> numbers;
+        // Every stored row, in the order the last applied sort left them; stored order until then.
+        std::vector<int> sortOrder;
+        // Trigram index over the pool's strings for keyword and type filters; until it is ready
+        // (or for small pools, which never get one) the filters test every string.
+        TrigramIndex keywordIndex;
+        bool keywordIndexReady = false;
+    };
+
+    // One view update: a snapshot of the table and everything the view is sorted and filtered by.
+    struct ViewRequest {
+        quint64 generation = 0;
+        // The newest generation requested; a request that falls behind it stops early.
+        std::shared_ptr<const QAtomicInteger<quint64>> latestGeneration;
+        TableData data;
+        QList<SortKey> sorts;
+        FilterBase base;
+        QString keyword;
+        // Set when the keyword only narrows the published view under the same base, which is
+        // then refined instead of filtered again.
+        bool refine = false;
+        QString appliedKeyword;
+        std::vector<int> appliedRows;
+        QList<bool> appliedKeyMatches;
+    };
+
+    struct ViewResult {
+        quint64 generation = 0;
+        // Whether sortOrder holds the request's sorts applied to the snapshot's order.
+        bool sorted = false;
+        std::vector<int> sortOrder;
+        std::vector<int> rows;
+        FilterBase base;
+        QString keyword;
+        QList<bool> keyMatches;
+    };
+
+    // Brings the view up to date with the filters and pending sorts: at once for a cached
+    // keyword or a small table, otherwise on the thread pool.
     void rebuildFilteredRows();
+    void adoptView();
+    // Swaps in a finished view as a layout change, keeping persistent indexes on their rows.
+    void publishView(ViewResult result);
+    static ViewResult computeView(const ViewRequest &request);
+    static void applySort(const TableData &data, const SortKey &sort, std::vector<int> *order);
+    // Per string id, whether the string contains needle, ignoring case. With within, only the
+    // ids it marks are tested; the rest are false.
+    static QList<bool> matchingIds(const TableData &data, const QString &needle, const QList<bool> *within = nullptr);
+    static bool matchesKeyword(const TableData &data, int row, const QList<bool> &keyMatches);
+    // project and type are the trimmed filters.
+    static Scope resolveScope(const TableData &data, const QString &project, const QString &type);
+    static bool inScope(const TableData &data, int row, const Scope &scope);
+    static bool inNumericRanges(const TableData &data, const std::array<NumericRange, NumericFieldCount> &ranges, int row);
+    // Stored rows passing the project and type filters, in stored order.
+    QList<int> scopedRows() const;
+    void resolveNumericColumns(const QList<int> &numericColumns);
+    void appendSourceRows(const QList<QStringList> &rows);
+    // Brings the keyword index up to date with the pool: new strings are added in place while
+    // the index is ready, and a pool large enough to need one gets a build on the thread pool.
+    void refreshKeywordIndex();
+    void adoptKeywordIndex();
+    // Keeps only the given stored rows (ascending) in text and numeric columns alike,
+    // renumbering the sort order and the filtered view to match.
+    void keepSourceRows(const QList<int> &rows);
+    int numericFieldOfColumn(int sourceColumn) const;
 
     QStringList m_sourceHeaders;
-    QList<QStringList> m_sourceRows;
-    QList<QStringList> m_filteredRows;
+    TableData m_data;
+    // Sorts requested since the last published view, applied in order by the next one.
+    QList<SortKey> m_pendingSorts;
+    // Stored rows shown by the view, in view order: the sort order minus filtered-out rows.
+    std::vector<int> m_filteredRows;
+    // Bumped whenever stored rows change or a sort is requested.
+    quint64 m_rowsGeneration = 0;
+    // The base and keyword m_filteredRows was filtered with, and per string id whether it
+    // matched that keyword (empty without one).
+    FilterBase m_filterBase;
+    QString m_appliedKeyword;
+    QList<bool> m_keyMatches;
+    // Recent keyword results under m_filterBase, most recent first.
+    QList<FilterCacheEntry> m_filterCache;
+    // Bumped by every view update requested; only the newest one's result is published.
+    std::shared_ptr<QAtomicInteger<quint64>> m_viewGeneration = std::make_shared<QAtomicInteger<quint64>>(0);
+    QFutureWatcher<ViewResult> m_viewWatcher;
+    QFutureWatcher<TrigramIndex> m_keywordIndexWatcher;
+    // Bumped whenever pool ids are reset or renumbered, which makes a build in flight stale.
+    quint64 m_poolGeneration = 0;
+    quint64 m_keywordIndexGeneration = 0;
     QList<int> m_visibleSourceColumns;
     QString m_filterKeyword;
     QString m_projectFilter;
     QString m_typeFilter;
+    std::array<int, NumericFieldCount> m_numericColumns = {-1, -1, -1};
+    std::array<NumericRange, NumericFieldCount> m_numericRanges;
 };
 
@@ -0,0 +1,82 @@
+#include "ColumnTable.h"
+
+#include <utility>
+
+void ColumnTable::reset(int columnCount)
+{
+    m_columns = QList<QList<quint32>>(qMax(0, columnCount));
+    m_pool = StringPool();
+    m_rowCount = 0;
+}
+
+void ColumnTable::reserve(int rowCount)
+{
+    for (QList<quint32> &column : m_columns) {
+        column.reserve(rowCount);
+    }
+}
+
+void ColumnTable::appendRow(const QStringList &cells)
+{
+    for (int i = 0; i < m_columns.size(); ++i) {
+        m_columns[i].append(i < cells.size() ? m_pool.intern(cells[i]) : m_pool.intern(QStringView()));
+    }
+    ++m_rowCount;
+}
+
+QStringList ColumnTable::row(int row) const
+{
+    QStringList cells;
+    cells.reserve(m_columns.size());
+    for (const QList<quint32> &column : m_columns) {
+        cells.append(m_pool.string(column[row]));
+    }
+    return cells;
+}
+
+QList<quint32> ColumnTable::rowIds(int row) const
+{
+    QList<quint32> ids;
+    ids.reserve(m_columns.size());
+    for (const QList<quint32> &column : m_columns) {
+        ids.append(column[row]);
+    }
+    return ids;
+}
+
+void ColumnTable::selectRows(const QList<int> &rows, QList<quint32> *remap)
+{
+    if (remap) {
+        remap->clear();
+    }
+    const bool dropsRows = rows.size() != m_rowCount;
+    for (QList<quint32> &column : m_columns) {
+        QList<quint32> selected;
+        selected.reserve(rows.size());
+        for (const int row : rows) {
+            selected.append(column[row]);
+        }
+        column = std::move(selected);
+    }
+    m_rowCount = int(rows.size());
+    if (!dropsRows) {
+        return;
+    }
+
+    m_pool.clearCounts();
+    for (const QList<quint32> &column : std::as_const(m_columns)) {
+        for (const quint32 id : column) {
+            m_pool.addUses(id, 1);
+        }
+    }
+    QList<quint32> renumbered;
+    m_pool.compact(&renumbered);
+    for (QList<quint32> &column : m_columns) {
+        for (quint32 &id : column) {
+            id = renumbered[id];
+        }
+    }
+    if (remap) {
+        *remap = std::move(renumbered);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "StringPool.h"
+
+// Text cells stored column by column, dictionary encoded: each column is a list of ids into
+// one string pool shared by all columns, so a stored row costs an integer per cell, equal
+// values compare as integers, and scanning one column walks contiguous memory. Every row is
+// as wide as the table; missing cells read as empty and cells past the last column are dropped.
+class ColumnTable
+{
+public:
+    // Drops all rows and strings and sets the width.
+    void reset(int columnCount);
+
+    int rowCount() const { return m_rowCount; }
+    int columnCount() const { return int(m_columns.size()); }
+    const StringPool &pool() const { return m_pool; }
+
+    void reserve(int rowCount);
+    void appendRow(const QStringList &cells);
+
+    quint32 cellId(int row, int column) const { return m_columns[column][row]; }
+    const QString &cell(int row, int column) const { return m_pool.string(cellId(row, column)); }
+    QStringList row(int row) const;
+    QList<quint32> rowIds(int row) const;
+
+    // Keeps only the given rows, in the given order; also reorders the table. Strings no
+    // longer used are dropped from the pool, which renumbers the ids; remap then receives the
+    // new id of each old one (see StringPool::compact()), and is left empty otherwise.
+    void selectRows(const QList<int> &rows, QList<quint32> *remap = nullptr);
+
+private:
+    QList<QList<quint32>> m_columns;
+    StringPool m_pool;
+    int m_rowCount = 0;
+};
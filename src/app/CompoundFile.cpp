@@ -0,0 +1,233 @@
+#include "CompoundFile.h"
+
+#include <utility>
+
+namespace {
+constexpr quint32 EndOfChain = 0xFFFFFFFE;
+constexpr quint32 MaxRegularSector = 0xFFFFFFFA;
+constexpr int HeaderSize = 512;
+constexpr int HeaderDifatEntries = 109;
+constexpr int DirectoryEntrySize = 128;
+constexpr quint8 StreamEntry = 2;
+constexpr quint8 RootEntry = 5;
+const char Signature[] = "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1";
+
+quint16 read16(const char *p)
+{
+    const auto *u = reinterpret_cast<const uchar *>(p);
+    return quint16(u[0] | (u[1] << 8));
+}
+
+quint32 read32(const char *p)
+{
+    const auto *u = reinterpret_cast<const uchar *>(p);
+    return quint32(u[0]) | (quint32(u[1]) << 8) | (quint32(u[2]) << 16) | (quint32(u[3]) << 24);
+}
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+} // namespace
+
+bool CompoundFile::open(const QString &path, QString *error)
+{
+    m_fat.clear();
+    m_miniFat.clear();
+    m_miniStream.clear();
+    m_entries.clear();
+    m_buffer.clear();
+    m_data = QByteArrayView();
+    m_file.close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        setError(error, QStringLiteral("Cannot open file: %1").arg(path));
+        return false;
+    }
+    if (const uchar *mapped = m_file.size() > 0 ? m_file.map(0, m_file.size()) : nullptr) {
+        m_data = QByteArrayView(reinterpret_cast<const char *>(mapped), m_file.size());
+    } else {
+        m_buffer = m_file.readAll();
+        m_data = m_buffer;
+    }
+
+    const QString corrupt = QStringLiteral("Corrupt compound file: %1").arg(path);
+    if (m_data.size() < HeaderSize || !m_data.startsWith(QByteArrayView(Signature, 8))) {
+        setError(error, QStringLiteral("Not an OLE2 compound file: %1").arg(path));
+        return false;
+    }
+
+    const char *header = m_data.data();
+    const int sectorShift = read16(header + 0x1E);
+    const int miniSectorShift = read16(header + 0x20);
+    if ((sectorShift != 9 && sectorShift != 12) || miniSectorShift != 6) {
+        setError(error, corrupt);
+        return false;
+    }
+    m_sectorSize = 1 << sectorShift;
+    m_miniSectorSize = 1 << miniSectorShift;
+    const quint32 fatSectorCount = read32(header + 0x2C);
+    const quint32 firstDirectorySector = read32(header + 0x30);
+    m_miniStreamCutoff = read32(header + 0x38);
+    const quint32 firstMiniFatSector = read32(header + 0x3C);
+    quint32 difatSector = read32(header + 0x44);
+    const quint32 difatSectorCount = read32(header + 0x48);
+
+    // The DIFAT lists the sectors holding the FAT: 109 entries in the header, the rest in a
+    // chain of DIFAT sectors whose last slot links to the next.
+    const qsizetype sectorCount = (m_data.size() - HeaderSize) / m_sectorSize;
+    if (fatSectorCount > quint32(sectorCount)) {
+        setError(error, corrupt);
+        return false;
+    }
+    QList<quint32> fatSectors;
+    fatSectors.reserve(fatSectorCount);
+    for (int i = 0; i < HeaderDifatEntries && quint32(fatSectors.size()) < fatSectorCount; ++i) {
+        fatSectors.append(read32(header + 0x4C + i * 4));
+    }
+    const int perDifatSector = m_sectorSize / 4 - 1;
+    for (quint32 n = 0; n < difatSectorCount && quint32(fatSectors.size()) < fatSectorCount; ++n) {
+        const QByteArrayView difat = sector(difatSector);
+        if (difat.isEmpty()) {
+            setError(error, corrupt);
+            return false;
+        }
+        for (int i = 0; i < perDifatSector && quint32(fatSectors.size()) < fatSectorCount; ++i) {
+            fatSectors.append(read32(difat.data() + i * 4));
+        }
+        difatSector = read32(difat.data() + perDifatSector * 4);
+    }
+
+    m_fat.reserve(qsizetype(fatSectors.size()) * (m_sectorSize / 4));
+    for (const quint32 index : std::as_const(fatSectors)) {
+        const QByteArrayView fat = sector(index);
+        if (fat.isEmpty()) {
+            setError(error, corrupt);
+            return false;
+        }
+        for (int i = 0; i < m_sectorSize / 4; ++i) {
+            m_fat.append(read32(fat.data() + i * 4));
+        }
+    }
+
+    QByteArray directory;
+    if (!readChain(firstDirectorySector, 0, &directory)) {
+        setError(error, corrupt);
+        return false;
+    }
+    for (qsizetype pos = 0; pos + DirectoryEntrySize <= directory.size(); pos += DirectoryEntrySize) {
+        const char *raw = directory.constData() + pos;
+        const int nameBytes = qBound(0, int(read16(raw + 0x40)) - 2, 62);
+        DirectoryEntry entry;
+        entry.name = QString::fromUtf16(reinterpret_cast<const char16_t *>(raw), nameBytes / 2);
+        entry.type = quint8(raw[0x42]);
+        entry.startSector = read32(raw + 0x74);
+        entry.size = read32(raw + 0x78);
+        // Version 3 files leave the high half undefined; only 4 KiB-sector files may use it.
+        if (m_sectorSize == 4096) {
+            entry.size |= quint64(read32(raw + 0x7C)) << 32;
+        }
+        m_entries.append(entry);
+    }
+    if (m_entries.isEmpty() || m_entries.first().type != RootEntry) {
+        setError(error, corrupt);
+        return false;
+    }
+
+    // The root entry's stream is the mini stream that small streams are carved from.
+    QByteArray miniFat;
+    if ((firstMiniFatSector < MaxRegularSector && !readChain(firstMiniFatSector, 0, &miniFat))
+        || !readChain(m_entries.first().startSector, m_entries.first().size, &m_miniStream)) {
+        setError(error, corrupt);
+        return false;
+    }
+    m_miniFat.reserve(miniFat.size() / 4);
+    for (qsizetype pos = 0; pos + 4 <= miniFat.size(); pos += 4) {
+        m_miniFat.append(read32(miniFat.constData() + pos));
+    }
+    return true;
+}
+
+bool CompoundFile::readStream(const QString &name, QByteArray *data, QString *error) const
+{
+    for (const DirectoryEntry &entry : m_entries) {
+        if (entry.type != StreamEntry || entry.name.compare(name, Qt::CaseInsensitive) != 0) {
+            continue;
+        }
+        const bool ok = entry.size < m_miniStreamCutoff ? readMiniChain(entry.startSector, entry.size, data)
+                                                        : readChain(entry.startSector, entry.size, data);
+        if (!ok) {
+            setError(error, QStringLiteral("Corrupt compound file stream: %1").arg(name));
+        }
+        return ok;
+    }
+    setError(error, QStringLiteral("Stream not found in compound file: %1").arg(name));
+    return false;
+}
+
+// size 0 reads the whole chain (directory and mini FAT record no size of their own).
+bool CompoundFile::readChain(quint32 start, quint64 size, QByteArray *data) const
+{
+    data->clear();
+    if (size > quint64(m_data.size())) {
+        return false;
+    }
+    data->reserve(qsizetype(size));
+
+    // A chain can never be longer than the FAT; anything longer is a loop.
+    qsizetype steps = 0;
+    for (quint32 current = start; current != EndOfChain; current = m_fat[current]) {
+        if (current >= quint32(m_fat.size()) || ++steps > m_fat.size()) {
+            return false;
+        }
+        const QByteArrayView bytes = sector(current);
+        if (bytes.isEmpty()) {
+            return false;
+        }
+        data->append(bytes);
+        if (size > 0 && quint64(data->size()) >= size) {
+            break;
+        }
+    }
+    if (size > 0) {
+        if (quint64(data->size()) < size) {
+            return false;
+        }
+        data->truncate(qsizetype(size));
+    }
+    return true;
+}
+
+bool CompoundFile::readMiniChain(quint32 start, quint64 size, QByteArray *data) const
+{
+    data->clear();
+    data->reserve(qsizetype(size));
+    qsizetype steps = 0;
+    for (quint32 current = start; quint64(data->size()) < size; current = m_miniFat[current]) {
+        if (current >= quint32(m_miniFat.size()) || ++steps > m_miniFat.size()) {
+            return false;
+        }
+        const qsizetype offset = qsizetype(current) * m_miniSectorSize;
+        if (offset + m_miniSectorSize > m_miniStream.size()) {
+            return false;
+        }
+        data->append(m_miniStream.constData() + offset, m_miniSectorSize);
+    }
+    data->truncate(qsizetype(size));
+    return true;
+}
+
+QByteArrayView CompoundFile::sector(quint32 index) const
+{
+    if (index >= MaxRegularSector) {
+        return {};
+    }
+    const qint64 offset = (qint64(index) + 1) * m_sectorSize;
+    if (offset + m_sectorSize > m_data.size()) {
+        return {};
+    }
+    return m_data.sliced(offset, m_sectorSize);
+}
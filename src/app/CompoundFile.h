@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Read-only OLE2 compound file (the container of .xls workbooks). The file is mapped; a
+// stream is assembled by following its sector chain through the FAT, or the mini FAT for
+// streams below the mini-stream cutoff.
+class CompoundFile
+{
+public:
+    bool open(const QString &path, QString *error);
+
+    // Looks the stream up by name in the whole directory (names are compared case-insensitively).
+    bool readStream(const QString &name, QByteArray *data, QString *error) const;
+
+private:
+    struct DirectoryEntry {
+        QString name;
+        quint8 type = 0;
+        quint32 startSector = 0;
+        quint64 size = 0;
+    };
+
+    bool readChain(quint32 start, quint64 size, QByteArray *data) const;
+    bool readMiniChain(quint32 start, quint64 size, QByteArray *data) const;
+    QByteArrayView sector(quint32 index) const;
+
+    QFile m_file;
+    QByteArray m_buffer;
+    QByteArrayView m_data;
+    int m_sectorSize = 512;
+    int m_miniSectorSize = 64;
+    quint32 m_miniStreamCutoff = 4096;
+    QList<quint32> m_fat;
+    QList<quint32> m_miniFat;
+    QByteArray m_miniStream;
+    QList<DirectoryEntry> m_entries;
+};
@@ -0,0 +1,326 @@
+#include "ConverterWorker.h"
+#include "AppLogger.h"
+#include "ImportTypes.h"
+
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QProcess>
+#include <QSettings>
+#include <QThread>
+#include <QtEndian>
+
+namespace {
+constexpr int StartTimeoutMs = 3000;
+constexpr int RequestTimeoutMs = 45000;
+constexpr int CancelPollMs = 100;
+constexpr quint32 MaxResponseSize = 16 * 1024 * 1024;
+
+// Stray prints from imported packages go to stderr so they cannot corrupt the framing.
+const QString WorkerScript = QStringLiteral(R"PY(
+import csv
+import json
+import struct
+import sys
+
+inp = sys.stdin.buffer
+out = sys.stdout.buffer
+sys.stdout = sys.stderr
+
+
+def convert_xls(in_path, out_path):
+    try:
+        import xlrd
+    except Exception as exc:
+        raise RuntimeError(f"Missing 'xlrd' dependency for .xls parsing: {exc}")
+
+    book = xlrd.open_workbook(in_path)
+    if book.nsheets <= 0:
+        raise RuntimeError('No worksheet found in xls file.')
+
+    sheet = book.sheet_by_index(0)
+    rows = []
+    for r in range(sheet.nrows):
+        line = []
+        for c in range(sheet.ncols):
+            cell = sheet.cell_value(r, c)
+            if isinstance(cell, float) and cell.is_integer():
+                line.append(str(int(cell)))
+            else:
+                line.append(str(cell))
+        rows.append(line)
+
+    with open(out_path, 'w', encoding='utf-8', newline='') as fp:
+        csv.writer(fp).writerows(rows)
+
+
+handlers = {'xls': convert_xls}
+
+while True:
+    header = inp.read(4)
+    if len(header) < 4:
+        break
+    (size,) = struct.unpack('>I', header)
+    request = json.loads(inp.read(size).decode('utf-8'))
+    try:
+        handlers[request['op']](request['in'], request['out'])
+        response = {'ok': True}
+    except Exception as exc:
+        response = {'ok': False, 'error': f'{type(exc).__name__}: {exc}'}
+    payload = json.dumps(response).encode('utf-8')
+    out.write(struct.pack('>I', len(payload)) + payload)
+    out.flush()
+)PY");
+
+QMutex hostMutex;
+QThread *workerThread = nullptr;
+ConverterWorker *worker = nullptr;
+
+// Waits in short slices so a cancellation is noticed while the interpreter is still busy.
+bool readExactly(QProcess *process, qint64 size, QByteArray *data, const QDeadlineTimer &deadline,
+                 const ImportMonitor *monitor)
+{
+    while (process->bytesAvailable() < size) {
+        if (monitor && monitor->isCanceled()) {
+            return false;
+        }
+        const int slice = int(qMin<qint64>(CancelPollMs, deadline.remainingTime()));
+        if (!process->waitForReadyRead(slice)
+            && (deadline.hasExpired() || process->state() == QProcess::NotRunning)) {
+            return false;
+        }
+    }
+    *data = process->read(size);
+    return true;
+}
+} // namespace
+
+ConverterWorker::Status ConverterWorker::convert(const QString &operation, const QString &inputPath,
+                                                 const QString &outputPath, QString *error,
+                                                 const ImportMonitor *monitor)
+{
+    {
+        QMutexLocker locker(&hostMutex);
+        if (!worker) {
+            workerThread = new QThread;
+            workerThread->setObjectName(QStringLiteral("ConverterWorker"));
+            worker = new ConverterWorker;
+            worker->moveToThread(workerThread);
+            workerThread->start();
+            qAddPostRoutine(&ConverterWorker::shutdown);
+        }
+    }
+
+    const QJsonObject request = {{QStringLiteral("op"), operation},
+                                 {QStringLiteral("in"), inputPath},
+                                 {QStringLiteral("out"), outputPath}};
+    Status status = Status::Unavailable;
+    QMetaObject::invokeMethod(
+        worker, [&] { status = worker->handle(request, error, monitor); }, Qt::BlockingQueuedConnection);
+    return status;
+}
+
+void ConverterWorker::shutdown()
+{
+    QMutexLocker locker(&hostMutex);
+    if (!worker) {
+        return;
+    }
+    QMetaObject::invokeMethod(worker, [] { worker->stop(); }, Qt::BlockingQueuedConnection);
+    workerThread->quit();
+    workerThread->wait();
+    delete worker;
+    delete workerThread;
+    worker = nullptr;
+    workerThread = nullptr;
+}
+
+ConverterWorker::Status ConverterWorker::handle(const QJsonObject &request, QString *error,
+                                                const ImportMonitor *monitor)
+{
+    if (monitor && monitor->isCanceled()) {
+        if (error) {
+            *error = QStringLiteral("Conversion canceled.");
+        }
+        return Status::Failed;
+    }
+    if (!ensureStarted(error)) {
+        return Status::Unavailable;
+    }
+
+    const QByteArray payload = QJsonDocument(request).toJson(QJsonDocument::Compact);
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), frame.data());
+    frame += payload;
+    m_process->write(frame);
+
+    const QDeadlineTimer deadline(RequestTimeoutMs);
+    QByteArray header;
+    QByteArray body;
+    const bool answered = readExactly(m_process, 4, &header, deadline, monitor)
+        && qFromBigEndian<quint32>(header.constData()) <= MaxResponseSize
+        && readExactly(m_process, qFromBigEndian<quint32>(header.constData()), &body, deadline, monitor);
+
+    const QString stdErr = QString::fromUtf8(m_process->readAllStandardError()).trimmed();
+    if (!stdErr.isEmpty()) {
+        AppLogger::debug(QStringLiteral("Converter worker stderr: %1").arg(stdErr));
+    }
+
+    if (!answered && monitor && monitor->isCanceled()) {
+        AppLogger::info(QStringLiteral("Conversion canceled, stopping converter worker."));
+        m_process->kill();
+        stop();
+        if (error) {
+            *error = QStringLiteral("Conversion canceled.");
+        }
+        return Status::Failed;
+    }
+
+    if (!answered) {
+        // A hung or crashed interpreter is replaced on the next request; one that died on its
+        // own (say, too old for the script) sends the next request back through detection.
+        AppLogger::warn(QStringLiteral("Converter worker did not answer, restarting it: %1").arg(stdErr));
+        if (m_process->state() == QProcess::NotRunning) {
+            m_resolved = false;
+            persistCommand(nullptr);
+        }
+        stop();
+        if (error) {
+            *error = stdErr.isEmpty() ? QStringLiteral("Python converter did not respond.") : stdErr;
+        }
+        return Status::Failed;
+    }
+
+    const QJsonObject response = QJsonDocument::fromJson(body).object();
+    if (response.value(QStringLiteral("ok")).toBool()) {
+        return Status::Ok;
+    }
+    if (error) {
+        *error = response.value(QStringLiteral("error")).toString();
+    }
+    return Status::Failed;
+}
+
+bool ConverterWorker::ensureStarted(QString *error)
+{
+    if (m_process && m_process->state() == QProcess::Running) {
+        return true;
+    }
+    stop();
+
+    // Probing runs at most once per session: the resolved command is kept here and in the
+    // settings, and only probed again when it stops working.
+    if (m_unavailable) {
+        if (error) {
+            *error = QStringLiteral("No Python interpreter found (tried: python3, python, py -3).");
+        }
+        return false;
+    }
+    if (!m_resolved) {
+        PythonCommand persisted;
+        if (loadPersistedCommand(&persisted) && startProcess(persisted)) {
+            m_python = persisted;
+            m_resolved = true;
+            return true;
+        }
+        if (!detectCommand(&m_python)) {
+            m_unavailable = true;
+            persistCommand(nullptr);
+            if (error) {
+                *error = QStringLiteral("No Python interpreter found (tried: python3, python, py -3).");
+            }
+            return false;
+        }
+        m_resolved = true;
+        persistCommand(&m_python);
+    }
+
+    if (!startProcess(m_python)) {
+        m_resolved = false;
+        persistCommand(nullptr);
+        if (error) {
+            *error = QStringLiteral("Failed to launch Python command: %1 %2")
+                         .arg(m_python.program, m_python.prefixArgs.join(' '));
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ConverterWorker::startProcess(const PythonCommand &python)
+{
+    m_process = new QProcess(this);
+    m_process->setProcessChannelMode(QProcess::SeparateChannels);
+    QStringList args = python.prefixArgs;
+    args << QStringLiteral("-u") << QStringLiteral("-c") << WorkerScript;
+    m_process->start(python.program, args);
+    if (!m_process->waitForStarted(StartTimeoutMs)) {
+        stop();
+        return false;
+    }
+    AppLogger::info(QStringLiteral("Converter worker started: %1 %2").arg(python.program, python.prefixArgs.join(' ')));
+    return true;
+}
+
+void ConverterWorker::stop()
+{
+    if (!m_process) {
+        return;
+    }
+    // The script exits on end of input; a hung one is killed.
+    if (m_process->state() != QProcess::NotRunning) {
+        m_process->closeWriteChannel();
+        if (!m_process->waitForFinished(1000)) {
+            m_process->kill();
+            m_process->waitForFinished(1000);
+        }
+    }
+    delete m_process;
+    m_process = nullptr;
+}
+
+bool ConverterWorker::loadPersistedCommand(PythonCommand *python)
+{
+    QSettings settings;
+    python->program = settings.value(QStringLiteral("converter/pythonProgram")).toString();
+    python->prefixArgs = settings.value(QStringLiteral("converter/pythonArgs")).toStringList();
+    return !python->program.isEmpty();
+}
+
+void ConverterWorker::persistCommand(const PythonCommand *python)
+{
+    QSettings settings;
+    if (python) {
+        settings.setValue(QStringLiteral("converter/pythonProgram"), python->program);
+        settings.setValue(QStringLiteral("converter/pythonArgs"), python->prefixArgs);
+    } else {
+        settings.remove(QStringLiteral("converter/pythonProgram"));
+        settings.remove(QStringLiteral("converter/pythonArgs"));
+    }
+}
+
+bool ConverterWorker::detectCommand(PythonCommand *python)
+{
+    const QList<PythonCommand> candidates = {
+        {QStringLiteral("python3"), {}},
+        {QStringLiteral("python"), {}},
+        {QStringLiteral("py"), {QStringLiteral("-3")}}
+    };
+
+    for (const PythonCommand &candidate : candidates) {
+        QProcess check;
+        QStringList args = candidate.prefixArgs;
+        args.append(QStringLiteral("--version"));
+        check.start(candidate.program, args);
+        if (!check.waitForStarted(2500)) {
+            continue;
+        }
+        check.waitForFinished(4000);
+        if (check.exitStatus() == QProcess::NormalExit && check.exitCode() == 0) {
+            *python = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class ImportMonitor;
+class QProcess;
+
+// Long-lived Python process that performs spreadsheet conversions on request, so a batch of
+// imports pays interpreter startup once. Requests and responses are UTF-8 JSON objects, each
+// framed by a 4-byte big-endian length, over the worker's stdin/stdout. The process and its
+// QProcess live on a dedicated thread; convert() can be called from any other thread and
+// blocks until the response arrives.
+class ConverterWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Status {
+        Ok,
+        // No interpreter could be started.
+        Unavailable,
+        // The interpreter ran the request and reported an error (message in *error).
+        Failed
+    };
+
+    // operation names a handler of the worker script ("xls"). Canceling monitor kills the
+    // interpreter mid-request; the next request starts a fresh one.
+    static Status convert(const QString &operation, const QString &inputPath, const QString &outputPath, QString *error,
+                          const ImportMonitor *monitor = nullptr);
+
+private:
+    struct PythonCommand {
+        QString program;
+        QStringList prefixArgs;
+    };
+
+    ConverterWorker() = default;
+
+    static void shutdown();
+
+    Status handle(const QJsonObject &request, QString *error, const ImportMonitor *monitor);
+    bool ensureStarted(QString *error);
+    bool startProcess(const PythonCommand &python);
+    void stop();
+
+    static bool loadPersistedCommand(PythonCommand *python);
+    static void persistCommand(const PythonCommand *python);
+    static bool detectCommand(PythonCommand *python);
+
+    QProcess *m_process = nullptr;
+    PythonCommand m_python;
+    bool m_resolved = false;
+    bool m_unavailable = false;
+};
@@ -0,0 +1,152 @@
+#include "CsvParallelParser.h"
+#include "ImportTypes.h"
+#include "StringPool.h"
+
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <cstring>
+
+namespace {
+
+// Records a chunk parses between cancel checks and progress reports.
+constexpr int MonitorInterval = 4096;
+
+} // namespace
+
+CsvParallelParser::CsvParallelParser(CsvRecordReader::Encoding encoding, int threadCount)
+    : m_encoding(encoding)
+    , m_threadCount(threadCount)
+{
+}
+
+QList<QStringList> CsvParallelParser::parseRows(QByteArrayView body, const RowBuilder &buildRow, ImportMonitor *monitor) const
+{
+    const qsizetype size = body.size();
+    const int threads = qMax(1, m_threadCount > 0 ? m_threadCount : QThreadPool::globalInstance()->maxThreadCount());
+
+    QList<Chunk> chunks;
+    qsizetype begin = 0;
+    for (int i = 1; i <= threads && begin < size; ++i) {
+        qsizetype end = size;
+        if (i < threads) {
+            const qsizetype nominal = qMax(begin, size / threads * i);
+            const void *newline = std::memchr(body.data() + nominal, '\n', static_cast<size_t>(size - nominal));
+            end = newline ? static_cast<const char *>(newline) - body.data() + 1 : size;
+        }
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        chunks.append(chunk);
+        begin = end;
+    }
+
+    parseChunks(body, chunks, buildRow, monitor);
+    if (monitor && monitor->isCanceled()) {
+        return {};
+    }
+
+    // A cut is a real record boundary only when the quotes before it are balanced; otherwise
+    // it split a quoted field, and the chunks on both sides are re-parsed as one range.
+    QList<Chunk> ranges;
+    ranges.reserve(chunks.size());
+    qint64 quotesBefore = 0;
+    bool anyStale = false;
+    for (Chunk &chunk : chunks) {
+        const qint64 quotes = chunk.quotes;
+        if (!ranges.isEmpty() && quotesBefore % 2 != 0) {
+            Chunk &previous = ranges.last();
+            previous.end = chunk.end;
+            previous.stale = true;
+            anyStale = true;
+        } else {
+            ranges.append(std::move(chunk));
+        }
+        quotesBefore += quotes;
+    }
+
+    if (anyStale) {
+        QList<Chunk> staleRanges;
+        for (const Chunk &range : ranges) {
+            if (range.stale) {
+                staleRanges.append(range);
+            }
+        }
+        // Already counted by the first pass, so the re-parse reports nothing.
+        parseChunks(body, staleRanges, buildRow, nullptr);
+        qsizetype next = 0;
+        for (Chunk &range : ranges) {
+            if (range.stale) {
+                range = std::move(staleRanges[next++]);
+            }
+        }
+    }
+
+    qsizetype total = 0;
+    for (const Chunk &range : ranges) {
+        total += range.rows.size();
+    }
+
+    QList<QStringList> rows;
+    rows.reserve(total);
+    for (Chunk &range : ranges) {
+        for (QStringList &row : range.rows) {
+            rows.append(std::move(row));
+        }
+    }
+    return rows;
+}
+
+void CsvParallelParser::parseChunk(QByteArrayView body, Chunk &chunk, const RowBuilder &buildRow, ImportMonitor *monitor) const
+{
+    chunk.rows.clear();
+    if (monitor && monitor->isCanceled()) {
+        return;
+    }
+    CsvRecordReader reader(body.sliced(chunk.begin, chunk.end - chunk.begin), m_encoding);
+    StringPool pool;
+    reader.setStringPool(&pool);
+    qsizetype reportedBytes = 0;
+    qsizetype reportedRows = 0;
+    int sinceReport = 0;
+    while (reader.next()) {
+        QStringList row;
+        if (buildRow(reader, &row)) {
+            chunk.rows.append(std::move(row));
+        }
+        if (monitor && ++sinceReport == MonitorInterval) {
+            sinceReport = 0;
+            monitor->addBytesRead(reader.position() - reportedBytes);
+            monitor->addRowsParsed(chunk.rows.size() - reportedRows);
+            reportedBytes = reader.position();
+            reportedRows = chunk.rows.size();
+            if (monitor->isCanceled()) {
+                return;
+            }
+        }
+    }
+    chunk.quotes = reader.quoteCount();
+    if (monitor) {
+        monitor->addBytesRead(reader.position() - reportedBytes);
+        monitor->addRowsParsed(chunk.rows.size() - reportedRows);
+    }
+}
+
+void CsvParallelParser::parseChunks(QByteArrayView body, QList<Chunk> &chunks, const RowBuilder &buildRow, ImportMonitor *monitor) const
+{
+    const auto parse = [this, body, &buildRow, monitor](Chunk &chunk) {
+        parseChunk(body, chunk, buildRow, monitor);
+    };
+
+    if (chunks.size() <= 1) {
+        for (Chunk &chunk : chunks) {
+            parse(chunk);
+        }
+    } else if (m_threadCount > 0) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(m_threadCount);
+        QtConcurrent::blockingMap(&pool, chunks, parse);
+    } else {
+        QtConcurrent::blockingMap(chunks, parse);
+    }
+}
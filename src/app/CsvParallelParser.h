@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QList>
+#include <QStringList>
+
+#include <functional>
+
+#include "CsvRecordReader.h"
+
+class ImportMonitor;
+
+// Parses the body of an in-memory CSV on the thread pool. The input is cut into chunks at
+// newlines on the speculation that each cut lies outside quotes; the per-chunk quote counts
+// then reveal any cut that fell inside a quoted field, and the affected neighbours are
+// re-parsed as one range. Rows come back in file order, identical to a serial pass.
+class CsvParallelParser
+{
+public:
+    // Returns false to drop the record; must be safe to call from several threads at once.
+    using RowBuilder = std::function<bool(const CsvRecordReader &record, QStringList *row)>;
+
+    static constexpr qsizetype MinimumParallelSize = 8 * 1024 * 1024;
+
+    explicit CsvParallelParser(CsvRecordReader::Encoding encoding, int threadCount = 0);
+
+    // body must start at a record boundary. Each chunk adds its bytes and rows to monitor as it
+    // goes; once monitor is canceled, chunks stop early and the result is incomplete.
+    QList<QStringList> parseRows(QByteArrayView body, const RowBuilder &buildRow, ImportMonitor *monitor = nullptr) const;
+
+private:
+    struct Chunk {
+        qsizetype begin = 0;
+        qsizetype end = 0;
+        qint64 quotes = 0;
+        bool stale = false;
+        QList<QStringList> rows;
+    };
+
+    void parseChunk(QByteArrayView body, Chunk &chunk, const RowBuilder &buildRow, ImportMonitor *monitor) const;
+    void parseChunks(QByteArrayView body, QList<Chunk> &chunks, const RowBuilder &buildRow, ImportMonitor *monitor) const;
+
+    CsvRecordReader::Encoding m_encoding;
+    int m_threadCount = 0;
+};
@@ -1,203 +1,349 @@
 #include "CsvParsers.h"
+#include "CsvParallelParser.h"
+#include "CsvRecordReader.h"
+#include "HeaderMatcher.h"
+#include "Inflate.h"
+#include "StringPool.h"
 
 #include <QFile>
-#include <QRegularExpression>
+#include <QHash>
 
 #include <algorithm>
+#include <iterator>
 
 namespace {
-QStringList parseCsvLine(const QString &line)
+// Non-blank records examined for the LCSC header before the file is rejected.
+constexpr int HeaderSearchRows = 64;
+// Records between progress reports and cancellation checks of a serial parse.
+constexpr int MonitorInterval = 4096;
+constexpr quint32 RequiredLichuangFields = (1u << HeaderMatcher::ItemCode) | (1u << HeaderMatcher::Model)
+    | (1u << HeaderMatcher::Qty) | (1u << HeaderMatcher::Amount);
+
+QString headerNotFoundError()
 {
-    QStringList result;
-    QString current;
-    bool inQuotes = false;
-
-    for (int i = 0; i < line.size(); ++i) {
-        const QChar ch = line[i];
-        if (ch == '"') {
-            if (inQuotes && i + 1 < line.size() && line[i + 1] == '"') {
-                current.append('"');
-                ++i;
-            } else {
-                inQuotes = !inQuotes;
-            }
-        } else if (ch == ',' && !inQuotes) {
-            result.append(current);
-            current.clear();
-        } else {
-            current.append(ch);
-        }
-    }
+    return QStringLiteral("Cannot detect LCSC header row in the first %1 rows (need item/model/qty/amount columns).")
+        .arg(HeaderSearchRows);
+}
 
-    result.append(current);
-    return result;
+// Source column of each LCSC output field, in HeaderMatcher::LichuangField order. Fields
+// missing from the header fall back to the fixed LCSC export layout.
+QList<int> lichuangSourceColumns(const HeaderMatcher::Detection &header)
+{
+    const auto column = [&](HeaderMatcher::LichuangField field, int fallbackIndex) {
+        return header.columns[field] >= 0 ? header.columns[field] : fallbackIndex;
+    };
+    return {column(HeaderMatcher::ItemCode, 1),
+            column(HeaderMatcher::Brand, 2),
+            column(HeaderMatcher::Model, 3),
+            column(HeaderMatcher::Package, 4),
+            column(HeaderMatcher::Name, 5),
+            column(HeaderMatcher::Qty, 6),
+            column(HeaderMatcher::UnitPrice, 9),
+            column(HeaderMatcher::Amount, 10)};
 }
+
+bool isBlankCell(const QStringList &cells, int column)
+{
+    return column < 0 || column >= cells.size() || cells[column].trimmed().isEmpty();
 }
 
-ImportResult LichuangCsvParser::parseFile(const QString &csvPath, const QString &projectName) const
+bool isBlankRow(const QStringList &cells)
 {
-    ImportResult result;
+    return std::all_of(cells.cbegin(), cells.cend(), [](const QString &cell) { return cell.trimmed().isEmpty(); });
+}
 
-    QFile file(csvPath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        result.error = QStringLiteral("Cannot open CSV file: %1").arg(csvPath);
-        return result;
+CsvRecordReader openReader(QByteArrayView *data)
+{
+    const CsvRecordReader::Encoding encoding
+        = CsvRecordReader::detectEncoding(data->first(qMin<qsizetype>(data->size(), CsvRecordReader::SniffWindowSize)));
+    if (encoding == CsvRecordReader::Encoding::Utf8 && data->startsWith("\xEF\xBB\xBF")) {
+        *data = data->sliced(3);
     }
+    return CsvRecordReader(*data, encoding);
+}
 
-    const QByteArray raw = file.readAll();
-    if (raw.isEmpty()) {
-        result.error = QStringLiteral("CSV file is empty: %1").arg(csvPath);
-        return result;
+// The file is mapped so cells stay byte spans into the page cache until a row is accepted;
+// files that cannot be mapped (pipes, some network shares) are streamed through the device.
+// whole, when given, receives the entire mapping including any BOM (empty when streamed).
+CsvRecordReader openReader(QFile &file, QByteArrayView *mapped, QByteArrayView *whole = nullptr)
+{
+    *mapped = QByteArrayView();
+    if (const uchar *data = file.map(0, file.size())) {
+        *mapped = QByteArrayView(reinterpret_cast<const char *>(data), file.size());
+    }
+    if (whole) {
+        *whole = *mapped;
     }
 
-    const auto normalized = [](QString text) {
-        return text.remove(' ').remove('\t').remove('\r').remove('\n').trimmed();
-    };
-    const auto containsAny = [](const QString &text, const QStringList &keys) {
-        for (const QString &key : keys) {
-            if (!key.isEmpty() && text.contains(key, Qt::CaseInsensitive)) {
-                return true;
+    if (mapped->isEmpty()) {
+        return CsvRecordReader(&file, CsvRecordReader::detectEncoding(file.peek(CsvRecordReader::SniffWindowSize)));
+    }
+    return openReader(mapped);
+}
+
+// The whole file, mapped when possible and read into buffer otherwise.
+QByteArrayView mapOrRead(QFile &file, QByteArray *buffer)
+{
+    if (const uchar *mapped = file.map(0, file.size())) {
+        return QByteArrayView(reinterpret_cast<const char *>(mapped), file.size());
+    }
+    *buffer = file.readAll();
+    return *buffer;
+}
+
+// A gzip-compressed CSV is inflated in memory and parsed from there like a mapped file; only
+// the compressed bytes are ever read from disk.
+bool readGzip(QFile &file, QByteArray *data, QString *error)
+{
+    if (!Inflate::isGzip(file.peek(2))) {
+        return false;
+    }
+    QByteArray buffer;
+    const QByteArrayView input = mapOrRead(file, &buffer);
+    if (!Inflate::gunzip(input, data)) {
+        *error = QStringLiteral("Corrupt or unsupported gzip file: %1").arg(file.fileName());
+    }
+    return true;
+}
+
+// A canceled parse stops early with whatever rows it has; the caller discards them.
+QList<QStringList> collectRows(CsvRecordReader &reader, QByteArrayView mapped, const CsvParallelParser::RowBuilder &buildRow,
+                               ImportMonitor *monitor = nullptr)
+{
+    if (mapped.size() >= CsvParallelParser::MinimumParallelSize) {
+        if (monitor) {
+            monitor->setBytesRead(reader.position());
+            monitor->setRowsParsed(0);
+        }
+        return CsvParallelParser(reader.encoding()).parseRows(mapped.sliced(reader.position()), buildRow, monitor);
+    }
+
+    // Cells repeat a few hundred values over many rows; the pool lets them share one copy each.
+    StringPool pool;
+    reader.setStringPool(&pool);
+    QList<QStringList> rows;
+    int sinceReport = 0;
+    while (reader.next()) {
+        QStringList row;
+        if (buildRow(reader, &row)) {
+            rows.append(row);
+        }
+        if (monitor && ++sinceReport == MonitorInterval) {
+            sinceReport = 0;
+            monitor->setBytesRead(reader.position());
+            monitor->setRowsParsed(rows.size());
+            if (monitor->isCanceled()) {
+                break;
             }
         }
-        return false;
-    };
-    const auto parseByText = [](const QString &text) {
-        QList<QStringList> rows;
-        const QStringList lines = text.split(QRegularExpression(QStringLiteral("\r?\n")));
-        rows.reserve(lines.size());
-        for (const QString &line : lines) {
-            rows.append(parseCsvLine(line));
+    }
+    reader.setStringPool(nullptr);
+    if (monitor) {
+        monitor->setBytesRead(reader.position());
+        monitor->setRowsParsed(rows.size());
+    }
+    return rows;
+}
+
+// columns holds the source column of each LCSC output field, in HeaderMatcher::LichuangField order.
+CsvParallelParser::RowBuilder lichuangRowBuilder(const QList<int> &columns, const QString &projectName)
+{
+    return [columns, projectName](const CsvRecordReader &record, QStringList *row) {
+        // Blank lines and all-empty rows are rejected on the raw bytes, before any decoding.
+        if (std::all_of(columns.cbegin(), columns.cend(), [&](int i) { return record.isBlankField(i); })) {
+            return false;
+        }
+
+        row->reserve(columns.size() + 1);
+        row->append(projectName);
+        for (const int column : columns) {
+            row->append(record.field(column).trimmed());
         }
-        return rows;
+        return true;
     };
+}
 
-    const QString textUtf8 = QString::fromUtf8(raw);
-    const QString textLocal = QString::fromLocal8Bit(raw);
+void setLichuangRows(ImportResult *result, const QList<QStringList> &rows)
+{
+    result->ok = true;
+    // The quantity, unit price and amount fields land in these output columns.
+    result->numericColumns = {6, 7, 8};
+    result->headers = {QStringLiteral("\u9879\u76ee"),
+                       QStringLiteral("\u5546\u54c1\u7f16\u53f7"),
+                       QStringLiteral("\u54c1\u724c"),
+                       QStringLiteral("\u5382\u5bb6\u578b\u53f7"),
+                       QStringLiteral("\u5c01\u88c5"),
+                       QStringLiteral("\u5546\u54c1\u540d\u79f0"),
+                       QStringLiteral("\u8ba2\u8d2d\u6570\u91cf\uff08\u4fee\u6539\u540e\uff09"),
+                       QStringLiteral("\u5546\u54c1\u5355\u4ef7"),
+                       QStringLiteral("\u5546\u54c1\u91d1\u989d")};
+    result->rows = rows;
+}
 
-    QList<QStringList> lines = parseByText(textUtf8);
-    if (lines.size() < 2) {
-        lines = parseByText(textLocal);
+// The file can only be continued when it ends on a record boundary; the prefix hash later
+// proves that nothing before that boundary was rewritten. bytes are exactly the file bytes
+// that were parsed, so rows written meanwhile stay past the offset for the next import.
+void captureResumeState(QByteArrayView bytes, CsvRecordReader::Encoding encoding, const QList<int> &columns,
+                        CsvResumeState *resume)
+{
+    resume->resumable = false;
+    if (!bytes.endsWith('\n')) {
+        return;
     }
+    resume->resumable = true;
+    resume->offset = bytes.size();
+    resume->prefixHash = qHashBits(bytes.data(), static_cast<size_t>(bytes.size()), 0);
+    resume->encoding = encoding;
+    resume->columns = columns;
+}
 
-    const QStringList itemCodeKeys = {
-        QStringLiteral("\u5546\u54c1\u7f16\u53f7"), QStringLiteral("\u6599\u53f7"),
-        QStringLiteral("item"), QStringLiteral("part"), QStringLiteral("lcsc")
-    };
-    const QStringList brandKeys = {
-        QStringLiteral("\u54c1\u724c"), QStringLiteral("brand")
-    };
-    const QStringList modelKeys = {
-        QStringLiteral("\u5382\u5bb6\u578b\u53f7"), QStringLiteral("\u578b\u53f7"),
-        QStringLiteral("mpn"), QStringLiteral("manufacturer")
-    };
-    const QStringList packageKeys = {
-        QStringLiteral("\u5c01\u88c5"), QStringLiteral("package")
-    };
-    const QStringList nameKeys = {
-        QStringLiteral("\u5546\u54c1\u540d\u79f0"), QStringLiteral("\u63cf\u8ff0"),
-        QStringLiteral("name"), QStringLiteral("description")
-    };
-    const QStringList qtyKeys = {
-        QStringLiteral("\u8ba2\u8d2d\u6570\u91cf"), QStringLiteral("\u6570\u91cf"),
-        QStringLiteral("qty"), QStringLiteral("quantity")
-    };
-    const QStringList unitPriceKeys = {
-        QStringLiteral("\u5546\u54c1\u5355\u4ef7"), QStringLiteral("\u5355\u4ef7"),
-        QStringLiteral("unit"), QStringLiteral("price")
-    };
-    const QStringList amountKeys = {
-        QStringLiteral("\u5546\u54c1\u91d1\u989d"), QStringLiteral("\u91d1\u989d"),
-        QStringLiteral("amount"), QStringLiteral("total")
-    };
-
-    int headerRow = -1;
-    for (int r = 0; r < lines.size(); ++r) {
-        const QStringList row = lines[r];
-        const auto at = [&](int index) { return index >= 0 && index < row.size() ? normalized(row[index]) : QString(); };
-        const QString merged = normalized(row.join(QString()));
+ImportResult parseLichuangRecords(CsvRecordReader &reader, QByteArrayView mapped, const QString &projectName,
+                                  QList<int> *columns, ImportMonitor *monitor)
+{
+    ImportResult result;
 
-        const bool headerByMerged = containsAny(merged, itemCodeKeys)
-            && containsAny(merged, modelKeys)
-            && containsAny(merged, qtyKeys)
-            && containsAny(merged, amountKeys);
+    const HeaderMatcher &matcher = HeaderMatcher::lichuangColumns();
+
+    // Banner rows above the header are matched through a reused scratch string, so they are
+    // never materialised as cells; only the header row itself is decoded into a list.
+    QString cell;
+    QList<quint32> cellMatches;
+    QStringList headerCells;
+    HeaderMatcher::Detection header;
+    int examined = 0;
+    while (examined < HeaderSearchRows && reader.next()) {
+        if (reader.isBlankRecord()) {
+            continue;
+        }
+        ++examined;
 
-        const bool headerByKnownColumns = containsAny(at(1), itemCodeKeys)
-            && containsAny(at(3), modelKeys)
-            && containsAny(at(6), qtyKeys)
-            && containsAny(at(10), amountKeys);
+        cellMatches.resize(reader.fieldCount());
+        for (int i = 0; i < reader.fieldCount(); ++i) {
+            reader.decodeField(i, &cell);
+            cellMatches[i] = matcher.match(cell);
+        }
 
-        if (headerByMerged || headerByKnownColumns) {
-            headerRow = r;
+        const HeaderMatcher::Detection candidate = matcher.score(cellMatches);
+        if (candidate.covers(RequiredLichuangFields)) {
+            header = candidate;
+            headerCells = reader.fields();
             break;
         }
     }
 
-    if (headerRow < 0) {
-        result.error = QStringLiteral("Cannot detect LCSC header row (need item/model/qty/amount columns).");
+    if (headerCells.isEmpty()) {
+        result.error = headerNotFoundError();
         return result;
     }
 
-    const QStringList headerCells = lines.value(headerRow);
-    auto findColumn = [&](const QStringList &keys, int fallbackIndex) {
-        for (int i = 0; i < headerCells.size(); ++i) {
-            if (containsAny(normalized(headerCells[i]), keys)) {
-                return i;
-            }
+    *columns = lichuangSourceColumns(header);
+    const QList<QStringList> rows = collectRows(reader, mapped, lichuangRowBuilder(*columns, projectName), monitor);
+    if (rows.isEmpty()) {
+        result.error = QStringLiteral("No valid BOM rows found after the detected header row.");
+        return result;
+    }
+
+    setLichuangRows(&result, rows);
+    result.headerConfidence = header.confidence;
+    return result;
+}
+
+bool readHeaderRecord(CsvRecordReader &reader, QStringList *headers)
+{
+    while (reader.next()) {
+        if (!reader.isBlankRecord()) {
+            *headers = reader.fields();
+            return true;
         }
-        return fallbackIndex;
-    };
+    }
+    return false;
+}
 
-    const int colItemCode = findColumn(itemCodeKeys, 1);
-    const int colBrand = findColumn(brandKeys, 2);
-    const int colModel = findColumn(modelKeys, 3);
-    const int colPackage = findColumn(packageKeys, 4);
-    const int colName = findColumn(nameKeys, 5);
-    const int colQty = findColumn(qtyKeys, 6);
-    const int colUnitPrice = findColumn(unitPriceKeys, 9);
-    const int colAmount = findColumn(amountKeys, 10);
+// Pads short rows, names blank or missing headers and fills in the project column, which is
+// prepended when the header has none.
+ImportResult finishGenericRows(QStringList headers, QList<QStringList> rows, const QString &projectName)
+{
+    ImportResult result;
+    int projectIndex = HeaderMatcher::projectColumn().findColumn(headers, 0);
 
-    QList<QStringList> rows;
-    for (int r = headerRow + 1; r < lines.size(); ++r) {
-        const QStringList row = lines[r];
-        const auto at = [&](int i) { return i >= 0 && i < row.size() ? row[i].trimmed() : QString(); };
-
-        const QString itemCode = at(colItemCode);
-        const QString brand = at(colBrand);
-        const QString model = at(colModel);
-        const QString pkg = at(colPackage);
-        const QString name = at(colName);
-        const QString qty = at(colQty);
-        const QString unitPrice = at(colUnitPrice);
-        const QString amount = at(colAmount);
-
-        if (itemCode.isEmpty() && brand.isEmpty() && model.isEmpty() && pkg.isEmpty()
-            && name.isEmpty() && qty.isEmpty() && unitPrice.isEmpty() && amount.isEmpty()) {
-            continue;
+    int maxCols = headers.size();
+    for (const QStringList &row : rows) {
+        maxCols = std::max(maxCols, static_cast<int>(row.size()));
+    }
+
+    if (projectIndex < 0) {
+        headers.prepend(QStringLiteral("项目"));
+        projectIndex = 0;
+        maxCols += 1;
+    }
+
+    if (headers.size() < maxCols) {
+        for (int i = headers.size(); i < maxCols; ++i) {
+            headers.append(QStringLiteral("列%1").arg(i + 1));
         }
+    }
 
-        rows.append({projectName, itemCode, brand, model, pkg, name, qty, unitPrice, amount});
+    for (int i = 0; i < headers.size(); ++i) {
+        if (headers[i].trimmed().isEmpty()) {
+            headers[i] = QStringLiteral("列%1").arg(i + 1);
+        }
+    }
+
+    for (QStringList &record : rows) {
+        if (projectIndex == 0 && record.size() < headers.size()) {
+            record.prepend(projectName);
+        }
+
+        if (projectIndex >= 0 && projectIndex < record.size() && record[projectIndex].trimmed().isEmpty()) {
+            record[projectIndex] = projectName;
+        }
+
+        if (record.size() < headers.size()) {
+            record.reserve(headers.size());
+            while (record.size() < headers.size()) {
+                record.append(QString());
+            }
+        } else if (record.size() > headers.size()) {
+            while (headers.size() < record.size()) {
+                headers.append(QStringLiteral("列%1").arg(headers.size() + 1));
+            }
+        }
     }
 
     if (rows.isEmpty()) {
-        result.error = QStringLiteral("No valid BOM rows found after the detected header row.");
+        result.error = QStringLiteral("No valid rows found after the header.");
         return result;
     }
 
     result.ok = true;
-    result.headers = {QStringLiteral("\u9879\u76ee"),
-                      QStringLiteral("\u5546\u54c1\u7f16\u53f7"),
-                      QStringLiteral("\u54c1\u724c"),
-                      QStringLiteral("\u5382\u5bb6\u578b\u53f7"),
-                      QStringLiteral("\u5c01\u88c5"),
-                      QStringLiteral("\u5546\u54c1\u540d\u79f0"),
-                      QStringLiteral("\u8ba2\u8d2d\u6570\u91cf\uff08\u4fee\u6539\u540e\uff09"),
-                      QStringLiteral("\u5546\u54c1\u5355\u4ef7"),
-                      QStringLiteral("\u5546\u54c1\u91d1\u989d")};
+    result.headers = headers;
     result.rows = rows;
     return result;
 }
 
-ImportResult GenericCsvParser::parseFile(const QString &csvPath, const QString &projectName) const
+ImportResult parseGenericRecords(CsvRecordReader &reader, QByteArrayView mapped, const QString &projectName,
+                                 ImportMonitor *monitor)
+{
+    QStringList headers;
+    if (!readHeaderRecord(reader, &headers)) {
+        ImportResult result;
+        result.error = QStringLiteral("Cannot detect header row in CSV file.");
+        return result;
+    }
+
+    const QList<QStringList> rows = collectRows(reader, mapped, [](const CsvRecordReader &record, QStringList *row) {
+        if (record.isBlankRecord()) {
+            return false;
+        }
+        *row = record.fields();
+        return true;
+    }, monitor);
+    return finishGenericRows(headers, rows, projectName);
+}
+}
+
+ImportResult LichuangCsvParser::parseFile(const QString &csvPath, const QString &projectName, CsvResumeState *resume,
+                                          ImportMonitor *monitor) const
 {
     ImportResult result;
 
@@ -207,155 +353,280 @@ ImportResult GenericCsvParser::parseFile(const QString &csvPath, const QString &
         return result;
     }
 
-    const QByteArray raw = file.readAll();
-    if (raw.isEmpty()) {
+    if (file.size() <= 0) {
         result.error = QStringLiteral("CSV file is empty: %1").arg(csvPath);
         return result;
     }
-
-    const auto parseByText = [](const QString &text) {
-        QList<QStringList> rows;
-        const QStringList lines = text.split(QRegularExpression(QStringLiteral("\r?\n")));
-        rows.reserve(lines.size());
-        for (const QString &line : lines) {
-            rows.append(parseCsvLine(line));
+    QByteArray inflated;
+    QString gzipError;
+    if (readGzip(file, &inflated, &gzipError)) {
+        if (resume) {
+            resume->resumable = false;
         }
-        return rows;
-    };
-
-    const QString textUtf8 = QString::fromUtf8(raw);
-    const QString textLocal = QString::fromLocal8Bit(raw);
-
-    QList<QStringList> linesUtf8 = parseByText(textUtf8);
-    QList<QStringList> linesLocal = parseByText(textLocal);
-    QList<QStringList> lines = linesUtf8;
-
-    auto findHeaderRow = [](const QList<QStringList> &rows) {
-        for (int r = 0; r < rows.size(); ++r) {
-            const QStringList row = rows[r];
-            const bool hasData = std::any_of(row.begin(), row.end(), [](const QString &cell) {
-                return !cell.trimmed().isEmpty();
-            });
-            if (hasData) {
-                return r;
-            }
+        if (!gzipError.isEmpty()) {
+            result.error = gzipError;
+            return result;
         }
-        return -1;
-    };
+        return parseData(inflated, projectName, monitor);
+    }
+    if (monitor) {
+        monitor->setTotalBytes(file.size());
+    }
 
-    int headerRow = findHeaderRow(lines);
-    if (headerRow < 0 && !linesLocal.isEmpty()) {
-        lines = linesLocal;
-        headerRow = findHeaderRow(lines);
+    QByteArrayView mapped;
+    QByteArrayView whole;
+    CsvRecordReader reader = openReader(file, &mapped, &whole);
+    QList<int> columns;
+    result = parseLichuangRecords(reader, mapped, projectName, &columns, monitor);
+    if (resume) {
+        resume->resumable = false;
+        if (result.ok) {
+            captureResumeState(whole, reader.encoding(), columns, resume);
+        }
     }
+    return result;
+}
 
-    if (headerRow < 0) {
-        result.error = QStringLiteral("Cannot detect header row in CSV file.");
+ImportResult LichuangCsvParser::parseData(QByteArrayView data, const QString &projectName, ImportMonitor *monitor) const
+{
+    if (data.isEmpty()) {
+        ImportResult result;
+        result.error = QStringLiteral("CSV data is empty.");
         return result;
     }
+    if (monitor) {
+        monitor->setTotalBytes(data.size());
+    }
+    CsvRecordReader reader = openReader(&data);
+    QList<int> columns;
+    return parseLichuangRecords(reader, data, projectName, &columns, monitor);
+}
 
-    auto normalize = [](const QString &text) {
-        return QString(text).remove(' ').remove('\t').remove('\r').remove('\n').trimmed().toLower();
-    };
+bool LichuangCsvParser::parseAppended(const QString &csvPath, const QString &projectName, CsvResumeState *resume,
+                                      ImportResult *result) const
+{
+    if (!resume->resumable) {
+        return false;
+    }
 
-    const QStringList projectKeys = {QStringLiteral("项目"), QStringLiteral("project")};
-    auto detectProjectIndex = [&](const QStringList &headers) {
-        for (int i = 0; i < headers.size(); ++i) {
-            const QString cell = normalize(headers[i]);
-            for (const QString &key : projectKeys) {
-                if (cell.contains(key)) {
-                    return i;
-                }
-            }
-        }
-        return -1;
-    };
+    QFile file(csvPath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < resume->offset) {
+        return false;
+    }
+    const uchar *data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
 
-    QStringList headers = lines.value(headerRow);
-    int projectIndex = detectProjectIndex(headers);
-
-    if (projectIndex < 0 && !linesLocal.isEmpty()) {
-        const int localHeaderRow = findHeaderRow(linesLocal);
-        if (localHeaderRow >= 0) {
-            const int localProjectIndex = detectProjectIndex(linesLocal.value(localHeaderRow));
-            if (localProjectIndex >= 0) {
-                lines = linesLocal;
-                headerRow = localHeaderRow;
-                headers = lines.value(headerRow);
-                projectIndex = localProjectIndex;
-            }
+    const QByteArrayView bytes(reinterpret_cast<const char *>(data), file.size());
+    if (qHashBits(bytes.data(), static_cast<size_t>(resume->offset), 0) != resume->prefixHash) {
+        return false;
+    }
+
+    // A writer may be midway through the last record, possibly inside a quoted cell spanning
+    // lines; it is left for the next change. Records ending before the data does ended at an
+    // unquoted newline; the one running to the end is complete only if the data ends in a
+    // newline and every quote seen is paired.
+    QByteArrayView tail = bytes.sliced(resume->offset);
+    qsizetype complete = 0;
+    CsvRecordReader scan(tail, resume->encoding);
+    while (scan.next()) {
+        const qsizetype end = scan.position();
+        if (end < tail.size() || (tail.endsWith('\n') && scan.quoteCount() % 2 == 0)) {
+            complete = end;
         }
     }
+    tail = tail.first(complete);
 
-    int maxCols = headers.size();
-    for (int r = headerRow + 1; r < lines.size(); ++r) {
-        const QStringList row = lines[r];
-        const bool hasData = std::any_of(row.begin(), row.end(), [](const QString &cell) {
-            return !cell.trimmed().isEmpty();
-        });
-        if (!hasData) {
+    CsvRecordReader reader(tail, resume->encoding);
+    setLichuangRows(result, collectRows(reader, tail, lichuangRowBuilder(resume->columns, projectName)));
+
+    resume->offset += tail.size();
+    resume->prefixHash = qHashBits(bytes.data(), static_cast<size_t>(resume->offset), 0);
+    return true;
+}
+
+ImportResult LichuangCsvParser::parseTable(const QList<QStringList> &table, const QString &projectName,
+                                           QStringList *sourceHeaders) const
+{
+    ImportResult result;
+    const HeaderMatcher &matcher = HeaderMatcher::lichuangColumns();
+
+    HeaderMatcher::Detection header;
+    qsizetype headerRow = -1;
+    int examined = 0;
+    QList<quint32> cellMatches;
+    for (qsizetype i = 0; i < table.size() && examined < HeaderSearchRows; ++i) {
+        const QStringList &cells = table[i];
+        if (isBlankRow(cells)) {
             continue;
         }
-        maxCols = std::max(maxCols, static_cast<int>(row.size()));
-    }
+        ++examined;
 
-    if (projectIndex < 0) {
-        headers.prepend(QStringLiteral("项目"));
-        projectIndex = 0;
-        maxCols += 1;
+        cellMatches.resize(cells.size());
+        for (int c = 0; c < cells.size(); ++c) {
+            cellMatches[c] = matcher.match(cells[c]);
+        }
+        const HeaderMatcher::Detection candidate = matcher.score(cellMatches);
+        if (candidate.covers(RequiredLichuangFields)) {
+            header = candidate;
+            headerRow = i;
+            break;
+        }
     }
 
-    if (headers.size() < maxCols) {
-        for (int i = headers.size(); i < maxCols; ++i) {
-            headers.append(QStringLiteral("列%1").arg(i + 1));
-        }
+    if (headerRow < 0) {
+        result.error = headerNotFoundError();
+        return result;
     }
 
-    for (int i = 0; i < headers.size(); ++i) {
-        if (headers[i].trimmed().isEmpty()) {
-            headers[i] = QStringLiteral("列%1").arg(i + 1);
+    const QList<int> columns = lichuangSourceColumns(header);
+    if (sourceHeaders) {
+        // The project column is filled in, not read from the file.
+        *sourceHeaders = {QString()};
+        for (const int column : columns) {
+            sourceHeaders->append(column < table[headerRow].size() ? table[headerRow][column].trimmed() : QString());
         }
     }
-
     QList<QStringList> rows;
-    for (int r = headerRow + 1; r < lines.size(); ++r) {
-        QStringList row = lines[r];
-        const bool hasData = std::any_of(row.begin(), row.end(), [](const QString &cell) {
-            return !cell.trimmed().isEmpty();
-        });
-        if (!hasData) {
+    rows.reserve(table.size() - headerRow - 1);
+    for (qsizetype i = headerRow + 1; i < table.size(); ++i) {
+        const QStringList &cells = table[i];
+        if (std::all_of(columns.cbegin(), columns.cend(), [&](int column) { return isBlankCell(cells, column); })) {
             continue;
         }
 
-        if (projectIndex == 0 && row.size() < headers.size()) {
-            row.prepend(projectName);
+        QStringList row;
+        row.reserve(columns.size() + 1);
+        row.append(projectName);
+        for (const int column : columns) {
+            row.append(column < cells.size() ? cells[column].trimmed() : QString());
         }
+        rows.append(row);
+    }
 
-        if (projectIndex >= 0 && projectIndex < row.size() && row[projectIndex].trimmed().isEmpty()) {
-            row[projectIndex] = projectName;
-        }
+    if (rows.isEmpty()) {
+        result.error = QStringLiteral("No valid BOM rows found after the detected header row.");
+        return result;
+    }
 
-        if (row.size() < headers.size()) {
-            row.reserve(headers.size());
-            while (row.size() < headers.size()) {
-                row.append(QString());
-            }
-        } else if (row.size() > headers.size()) {
-            while (headers.size() < row.size()) {
-                headers.append(QStringLiteral("列%1").arg(headers.size() + 1));
-            }
+    setLichuangRows(&result, rows);
+    result.headerConfidence = header.confidence;
+    return result;
+}
+
+ImportResult GenericCsvParser::parseFile(const QString &csvPath, const QString &projectName, ImportMonitor *monitor) const
+{
+    ImportResult result;
+
+    QFile file(csvPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.error = QStringLiteral("Cannot open CSV file: %1").arg(csvPath);
+        return result;
+    }
+
+    if (file.size() <= 0) {
+        result.error = QStringLiteral("CSV file is empty: %1").arg(csvPath);
+        return result;
+    }
+    QByteArray inflated;
+    QString gzipError;
+    if (readGzip(file, &inflated, &gzipError)) {
+        if (!gzipError.isEmpty()) {
+            result.error = gzipError;
+            return result;
         }
+        return parseData(inflated, projectName, monitor);
+    }
+    if (monitor) {
+        monitor->setTotalBytes(file.size());
+    }
 
-        rows.append(row);
+    QByteArrayView mapped;
+    CsvRecordReader reader = openReader(file, &mapped);
+    return parseGenericRecords(reader, mapped, projectName, monitor);
+}
+
+ImportResult GenericCsvParser::parseData(QByteArrayView data, const QString &projectName, ImportMonitor *monitor) const
+{
+    if (data.isEmpty()) {
+        ImportResult result;
+        result.error = QStringLiteral("CSV data is empty.");
+        return result;
+    }
+    if (monitor) {
+        monitor->setTotalBytes(data.size());
     }
+    CsvRecordReader reader = openReader(&data);
+    return parseGenericRecords(reader, data, projectName, monitor);
+}
 
-    if (rows.isEmpty()) {
-        result.error = QStringLiteral("No valid rows found after the header.");
+ImportResult GenericCsvParser::parseTable(const QList<QStringList> &table, const QString &projectName) const
+{
+    qsizetype headerRow = 0;
+    while (headerRow < table.size() && isBlankRow(table[headerRow])) {
+        ++headerRow;
+    }
+    if (headerRow == table.size()) {
+        ImportResult result;
+        result.error = QStringLiteral("Cannot detect header row in worksheet.");
         return result;
     }
 
-    result.ok = true;
-    result.headers = headers;
-    result.rows = rows;
-    return result;
+    QList<QStringList> rows;
+    rows.reserve(table.size() - headerRow - 1);
+    for (qsizetype i = headerRow + 1; i < table.size(); ++i) {
+        if (!isBlankRow(table[i])) {
+            rows.append(table[i]);
+        }
+    }
+    return finishGenericRows(table[headerRow], rows, projectName);
+}
+
+namespace CsvPreview {
+
+bool readFile(const QString &csvPath, int maxRecords, QList<QStringList> *records, QString *error)
+{
+    records->clear();
+    QFile file(csvPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QStringLiteral("Cannot open CSV file: %1").arg(csvPath);
+        return false;
+    }
+
+    if (Inflate::isGzip(file.peek(2))) {
+        QByteArray buffer;
+        const QByteArrayView input = mapOrRead(file, &buffer);
+        QByteArray data;
+        if (!Inflate::gunzip(input, &data, PreviewBytes)) {
+            *error = QStringLiteral("Corrupt or unsupported gzip file: %1").arg(csvPath);
+            return false;
+        }
+        readData(data, maxRecords, records, data.size() == PreviewBytes);
+        return true;
+    }
+
+    QByteArrayView mapped;
+    CsvRecordReader reader = openReader(file, &mapped);
+    QStringList cells;
+    while (records->size() < maxRecords && reader.readRecord(&cells)) {
+        records->append(cells);
+    }
+    return true;
 }
+
+void readData(QByteArrayView data, int maxRecords, QList<QStringList> *records, bool truncated)
+{
+    records->clear();
+    // The last line of a cut-off prefix is most likely incomplete.
+    if (truncated) {
+        data = data.first(data.lastIndexOf('\n') + 1);
+    }
+    CsvRecordReader reader = openReader(&data);
+    QStringList cells;
+    while (records->size() < maxRecords && reader.readRecord(&cells)) {
+        records->append(cells);
+    }
+}
+
+} // namespace CsvPreview
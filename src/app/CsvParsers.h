@@ -2,16 +2,54 @@
 
 #include <QString>
 
+#include "CsvRecordReader.h"
 #include "ImportTypes.h"
 
+// Where an LCSC parse ended, so a file that has only grown can be continued from there.
+struct CsvResumeState {
+    bool resumable = false;
+    qint64 offset = 0;
+    quint64 prefixHash = 0;
+    CsvRecordReader::Encoding encoding = CsvRecordReader::Encoding::Utf8;
+    QList<int> columns;
+};
+
 class LichuangCsvParser
 {
 public:
-    ImportResult parseFile(const QString &csvPath, const QString &projectName) const;
+    // monitor, when given, receives byte and row progress and can stop the parse early. A
+    // gzip-compressed file is inflated in memory and never resumable.
+    ImportResult parseFile(const QString &csvPath, const QString &projectName, CsvResumeState *resume = nullptr,
+                           ImportMonitor *monitor = nullptr) const;
+    // Parses CSV bytes already in memory, such as an entry inflated from an archive.
+    ImportResult parseData(QByteArrayView data, const QString &projectName, ImportMonitor *monitor = nullptr) const;
+    // Parses only the records appended since resume was taken and advances it. Returns false
+    // when the file no longer starts with the parsed bytes and must be parsed in full.
+    bool parseAppended(const QString &csvPath, const QString &projectName, CsvResumeState *resume,
+                       ImportResult *result) const;
+    // Same detection and row shaping over a worksheet that was read into memory. sourceHeaders,
+    // when given, receives the source header cell each output column is read from.
+    ImportResult parseTable(const QList<QStringList> &table, const QString &projectName,
+                            QStringList *sourceHeaders = nullptr) const;
 };
 
 class GenericCsvParser
 {
 public:
-    ImportResult parseFile(const QString &csvPath, const QString &projectName) const;
+    ImportResult parseFile(const QString &csvPath, const QString &projectName, ImportMonitor *monitor = nullptr) const;
+    ImportResult parseData(QByteArrayView data, const QString &projectName, ImportMonitor *monitor = nullptr) const;
+    ImportResult parseTable(const QList<QStringList> &table, const QString &projectName) const;
 };
+
+// The first records of a CSV as plain cells, for import previews. Only the start of the input
+// is read, however large the file is.
+namespace CsvPreview {
+
+// Inflated bytes read from a gzip-compressed (or archived) CSV for a preview.
+constexpr qsizetype PreviewBytes = 1024 * 1024;
+
+bool readFile(const QString &csvPath, int maxRecords, QList<QStringList> *records, QString *error);
+// truncated: data is a prefix, so its last line may be cut off and is dropped.
+void readData(QByteArrayView data, int maxRecords, QList<QStringList> *records, bool truncated);
+
+} // namespace CsvPreview
@@ -0,0 +1,406 @@
+#include "CsvRecordReader.h"
+#include "StringPool.h"
+
+#include <QIODevice>
+#include <QtAlgorithms>
+
+#include <cstring>
+
+CsvRecordReader::CsvRecordReader(QIODevice *device, Encoding encoding, qint64 chunkSize)
+    : m_device(device)
+    , m_encoding(encoding)
+    , m_chunkSize(qMax<qint64>(CsvScanner::BlockSize, chunkSize))
+    , m_scanBlock(CsvScanner::blockFunction(CsvScanner::bestKernel()))
+{
+    setupDecoder();
+}
+
+CsvRecordReader::CsvRecordReader(QByteArrayView data, Encoding encoding)
+    : m_encoding(encoding)
+    , m_scanBlock(CsvScanner::blockFunction(CsvScanner::bestKernel()))
+    , m_data(data.data())
+    , m_size(data.size())
+    , m_bytesRead(data.size())
+    , m_atEnd(true)
+{
+    setupDecoder();
+}
+
+CsvRecordReader::Encoding CsvRecordReader::detectEncoding(QByteArrayView prefix)
+{
+    if (prefix.startsWith("\xEF\xBB\xBF")) {
+        return Encoding::Utf8;
+    }
+
+    const auto *bytes = reinterpret_cast<const uchar *>(prefix.data());
+    const qsizetype size = prefix.size();
+
+    bool validUtf8 = true;
+    for (qsizetype i = 0; i < size && validUtf8;) {
+        const uchar lead = bytes[i];
+        if (lead < 0x80) {
+            ++i;
+            continue;
+        }
+
+        int length = 0;
+        uchar secondMin = 0x80;
+        uchar secondMax = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead == 0xE0) {
+            length = 3;
+            secondMin = 0xA0;
+        } else if (lead == 0xED) {
+            length = 3;
+            secondMax = 0x9F;
+        } else if (lead >= 0xE1 && lead <= 0xEF) {
+            length = 3;
+        } else if (lead == 0xF0) {
+            length = 4;
+            secondMin = 0x90;
+        } else if (lead == 0xF4) {
+            length = 4;
+            secondMax = 0x8F;
+        } else if (lead >= 0xF1 && lead <= 0xF3) {
+            length = 4;
+        } else {
+            validUtf8 = false;
+            break;
+        }
+
+        if (i + length > size) {
+            break; // Sequence cut by the sniff window.
+        }
+        validUtf8 = bytes[i + 1] >= secondMin && bytes[i + 1] <= secondMax;
+        for (int k = 2; k < length && validUtf8; ++k) {
+            validUtf8 = bytes[i + k] >= 0x80 && bytes[i + k] <= 0xBF;
+        }
+        i += length;
+    }
+    if (validUtf8) {
+        return Encoding::Utf8;
+    }
+
+    qsizetype gbSequences = 0;
+    qsizetype gbInvalid = 0;
+    for (qsizetype i = 0; i < size;) {
+        const uchar lead = bytes[i];
+        if (lead < 0x80) {
+            ++i;
+            continue;
+        }
+        if (lead == 0x80 || lead == 0xFF) {
+            ++gbInvalid;
+            ++i;
+            continue;
+        }
+        if (i + 1 >= size) {
+            break;
+        }
+
+        const uchar second = bytes[i + 1];
+        if (second >= 0x30 && second <= 0x39) {
+            if (i + 3 >= size) {
+                break;
+            }
+            if (bytes[i + 2] >= 0x81 && bytes[i + 2] <= 0xFE && bytes[i + 3] >= 0x30 && bytes[i + 3] <= 0x39) {
+                ++gbSequences;
+                i += 4;
+                continue;
+            }
+        } else if (second >= 0x40 && second <= 0xFE && second != 0x7F) {
+            ++gbSequences;
+            i += 2;
+            continue;
+        }
+        ++gbInvalid;
+        ++i;
+    }
+
+    if (gbSequences > 0 && gbInvalid * 20 <= gbSequences) {
+        return Encoding::Gb18030;
+    }
+    return Encoding::Local8Bit;
+}
+
+CsvRecordReader::Encoding CsvRecordReader::encoding() const
+{
+    return m_encoding;
+}
+
+void CsvRecordReader::setScanKernel(CsvScanner::Kernel kernel)
+{
+    m_scanBlock = CsvScanner::blockFunction(kernel);
+}
+
+void CsvRecordReader::setStringPool(StringPool *pool)
+{
+    m_pool = pool;
+}
+
+bool CsvRecordReader::next()
+{
+    m_fields.clear();
+    for (;;) {
+        if (scanRecord()) {
+            ++m_recordCount;
+            return true;
+        }
+        if (!m_atEnd) {
+            fillBuffer();
+            continue;
+        }
+
+        // The last record may end at EOF without a newline.
+        if (m_fields.isEmpty() && m_fieldStart >= m_size) {
+            return false;
+        }
+        finishField(m_size, m_size);
+        m_recordStart = m_size;
+        ++m_recordCount;
+        return true;
+    }
+}
+
+int CsvRecordReader::fieldCount() const
+{
+    return static_cast<int>(m_fields.size());
+}
+
+QByteArrayView CsvRecordReader::rawField(int index) const
+{
+    if (index < 0 || index >= m_fields.size()) {
+        return {};
+    }
+    const FieldSpan &span = m_fields[index];
+    return QByteArrayView(m_data + span.offset, span.size);
+}
+
+QString CsvRecordReader::field(int index) const
+{
+    const QByteArrayView raw = rawField(index);
+    if (raw.isEmpty()) {
+        return QString();
+    }
+    if (m_pool) {
+        decodeField(index, &m_decoded);
+        return m_pool->share(m_decoded);
+    }
+    return decode(unescape(raw));
+}
+
+QStringList CsvRecordReader::fields() const
+{
+    QStringList cells;
+    cells.reserve(m_fields.size());
+    for (int i = 0; i < m_fields.size(); ++i) {
+        cells.append(field(i));
+    }
+    return cells;
+}
+
+void CsvRecordReader::decodeField(int index, QString *out) const
+{
+    const QByteArrayView raw = unescape(rawField(index));
+    out->resize(m_decoder.requiredSpace(raw.size()));
+    const QChar *end = m_decoder.appendToBuffer(out->data(), raw);
+    out->resize(end - out->constData());
+}
+
+bool CsvRecordReader::isBlankField(int index) const
+{
+    const QByteArrayView raw = rawField(index);
+    bool inQuotes = false;
+    for (qsizetype i = 0; i < raw.size(); ++i) {
+        const uchar ch = static_cast<uchar>(raw[i]);
+        if (ch == '"') {
+            if (inQuotes && i + 1 < raw.size() && raw[i + 1] == '"') {
+                return false; // Escaped literal quote.
+            }
+            inQuotes = !inQuotes;
+            continue;
+        }
+        if (ch >= 0x80) {
+            // Non-ASCII whitespace (NBSP, U+3000) is only recognisable after decoding.
+            return field(index).trimmed().isEmpty();
+        }
+        if (ch != ' ' && (ch < '\t' || ch > '\r')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CsvRecordReader::isBlankRecord() const
+{
+    for (int i = 0; i < m_fields.size(); ++i) {
+        if (!isBlankField(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CsvRecordReader::readRecord(QStringList *cells)
+{
+    if (!next()) {
+        cells->clear();
+        return false;
+    }
+    *cells = fields();
+    return true;
+}
+
+qint64 CsvRecordReader::recordCount() const
+{
+    return m_recordCount;
+}
+
+qint64 CsvRecordReader::bytesRead() const
+{
+    return m_bytesRead;
+}
+
+qint64 CsvRecordReader::position() const
+{
+    return m_bytesRead - (m_size - m_recordStart);
+}
+
+qint64 CsvRecordReader::quoteCount() const
+{
+    return m_quoteCount;
+}
+
+void CsvRecordReader::setupDecoder()
+{
+    if (m_encoding == Encoding::Gb18030) {
+        m_decoder = QStringDecoder("GB18030", QStringConverter::Flag::Stateless);
+        if (m_decoder.isValid()) {
+            return;
+        }
+        m_encoding = Encoding::Local8Bit;
+    }
+    m_decoder = QStringDecoder(m_encoding == Encoding::Utf8 ? QStringConverter::Utf8 : QStringConverter::System,
+                               QStringConverter::Flag::Stateless);
+}
+
+bool CsvRecordReader::scanRecord()
+{
+    const char *data = m_data;
+    for (;;) {
+        while (m_pendingSeparators) {
+            const qsizetype pos = m_blockStart + qCountTrailingZeroBits(m_pendingSeparators);
+            m_pendingSeparators &= m_pendingSeparators - 1;
+            if (data[pos] == ',') {
+                finishField(pos, pos + 1);
+                continue;
+            }
+
+            const qsizetype end = (pos > m_fieldStart && data[pos - 1] == '\r') ? pos - 1 : pos;
+            finishField(end, pos + 1);
+            m_recordStart = pos + 1;
+            return true;
+        }
+
+        const qsizetype available = m_size - m_scanPos;
+        if (available <= 0 || (available < CsvScanner::BlockSize && !m_atEnd)) {
+            return false;
+        }
+
+        // Separators inside a quoted run are masked out by the running quote parity, so
+        // only record-relevant commas and newlines are visited one by one.
+        const CsvScanner::BlockMasks masks = available >= CsvScanner::BlockSize
+            ? m_scanBlock(data + m_scanPos)
+            : CsvScanner::scanPartialBlock(data + m_scanPos, available);
+        const quint64 inQuotes = CsvScanner::prefixXor(masks.quotes) ^ m_quoteCarry;
+        m_quoteCarry = quint64(0) - (inQuotes >> 63);
+        m_pendingSeparators = (masks.commas | masks.newlines) & ~inQuotes;
+        m_quoteCount += qPopulationCount(masks.quotes);
+        m_blockStart = m_scanPos;
+        m_scanPos += qMin(available, CsvScanner::BlockSize);
+    }
+}
+
+bool CsvRecordReader::fillBuffer()
+{
+    if (m_atEnd) {
+        return false;
+    }
+    if (!m_device) {
+        m_atEnd = true;
+        return false;
+    }
+
+    if (m_recordStart > 0) {
+        const qsizetype consumed = m_recordStart;
+        m_buffer.remove(0, consumed);
+        for (FieldSpan &span : m_fields) {
+            span.offset -= consumed;
+        }
+        m_recordStart = 0;
+        m_fieldStart -= consumed;
+        m_scanPos -= consumed;
+        m_blockStart -= consumed;
+    }
+
+    const qsizetype oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + m_chunkSize);
+    const qint64 count = m_device->read(m_buffer.data() + oldSize, m_chunkSize);
+    m_buffer.resize(oldSize + qMax<qint64>(0, count));
+    m_data = m_buffer.constData();
+    m_size = m_buffer.size();
+    if (count <= 0) {
+        m_atEnd = true;
+        return false;
+    }
+
+    // The BOM check waits until three bytes have arrived, which a sequential device may split.
+    if (m_bytesRead < 3 && m_bytesRead + count >= 3 && m_encoding == Encoding::Utf8
+        && m_buffer.startsWith("\xEF\xBB\xBF")) {
+        m_recordStart = m_fieldStart = m_scanPos = 3;
+    }
+    m_bytesRead += count;
+    return true;
+}
+
+void CsvRecordReader::finishField(qsizetype end, qsizetype nextStart)
+{
+    m_fields.append({m_fieldStart, qMax<qsizetype>(0, end - m_fieldStart)});
+    m_fieldStart = nextStart;
+}
+
+QByteArrayView CsvRecordReader::unescape(QByteArrayView raw) const
+{
+    if (raw.isEmpty() || !std::memchr(raw.data(), '"', static_cast<size_t>(raw.size()))) {
+        return raw;
+    }
+
+    m_unescaped.resize(0);
+    bool inQuotes = false;
+    for (qsizetype i = 0; i < raw.size(); ++i) {
+        const char ch = raw[i];
+        if (ch != '"') {
+            m_unescaped.append(ch);
+        } else if (inQuotes && i + 1 < raw.size() && raw[i + 1] == '"') {
+            m_unescaped.append('"');
+            ++i;
+        } else {
+            inQuotes = !inQuotes;
+        }
+    }
+    return m_unescaped;
+}
+
+QString CsvRecordReader::decode(QByteArrayView bytes) const
+{
+    switch (m_encoding) {
+    case Encoding::Utf8:
+        return QString::fromUtf8(bytes);
+    case Encoding::Gb18030:
+        return m_decoder.decode(bytes);
+    case Encoding::Local8Bit:
+        break;
+    }
+    return QString::fromLocal8Bit(bytes);
+}
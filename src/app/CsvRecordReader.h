@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QStringDecoder>
+#include <QStringList>
+#include <QVarLengthArray>
+
+#include "CsvScanner.h"
+
+class QIODevice;
+class StringPool;
+
+// Pulls fixed-size chunks from a device (or walks an in-memory view) and yields one CSV
+// record at a time. Quoted fields may span several lines (RFC 4180); "\r\n" and "\n" both
+// end a record. Fields stay byte spans into the input until field()/fields() decodes them;
+// spans are invalidated by the next call to next().
+class CsvRecordReader
+{
+public:
+    enum class Encoding {
+        Utf8,
+        Gb18030,
+        Local8Bit
+    };
+
+    static constexpr qint64 DefaultChunkSize = 64 * 1024;
+    static constexpr qint64 SniffWindowSize = 64 * 1024;
+
+    // Picks one decoder from the BOM and a bounded prefix of the input: valid UTF-8 wins,
+    // then GBK/GB18030 byte patterns (LCSC exports), then the local 8-bit codec.
+    static Encoding detectEncoding(QByteArrayView prefix);
+
+    explicit CsvRecordReader(QIODevice *device, Encoding encoding = Encoding::Utf8, qint64 chunkSize = DefaultChunkSize);
+    // Reads the bytes exactly as given (no BOM skipping); the view must outlive the reader.
+    explicit CsvRecordReader(QByteArrayView data, Encoding encoding = Encoding::Utf8);
+
+    Encoding encoding() const;
+    void setScanKernel(CsvScanner::Kernel kernel);
+    // With a pool, field() and fields() hand out its copies, so repeated values share their
+    // data and decode into a reused buffer; nullptr turns that off. The pool must outlive its use.
+    void setStringPool(StringPool *pool);
+
+    bool next();
+    int fieldCount() const;
+    QByteArrayView rawField(int index) const;
+    QString field(int index) const;
+    QStringList fields() const;
+    // Decodes into out, reusing its capacity, so rows that are only inspected cost no allocation.
+    void decodeField(int index, QString *out) const;
+    // True when the field is empty or whitespace once unquoted; ASCII input is checked in place.
+    bool isBlankField(int index) const;
+    bool isBlankRecord() const;
+
+    bool readRecord(QStringList *cells);
+    qint64 recordCount() const;
+    qint64 bytesRead() const;
+    qint64 position() const;
+    qint64 quoteCount() const;
+
+private:
+    struct FieldSpan {
+        qsizetype offset = 0;
+        qsizetype size = 0;
+    };
+
+    void setupDecoder();
+    bool scanRecord();
+    bool fillBuffer();
+    void finishField(qsizetype end, qsizetype nextStart);
+    QByteArrayView unescape(QByteArrayView raw) const;
+    QString decode(QByteArrayView bytes) const;
+
+    QIODevice *m_device = nullptr;
+    Encoding m_encoding = Encoding::Utf8;
+    mutable QStringDecoder m_decoder;
+    qint64 m_chunkSize = DefaultChunkSize;
+    CsvScanner::BlockFunction m_scanBlock = nullptr;
+    QByteArray m_buffer;
+    mutable QByteArray m_unescaped;
+    StringPool *m_pool = nullptr;
+    mutable QString m_decoded;
+    const char *m_data = nullptr;
+    qsizetype m_size = 0;
+    QVarLengthArray<FieldSpan, 32> m_fields;
+    qsizetype m_recordStart = 0;
+    qsizetype m_fieldStart = 0;
+    qsizetype m_scanPos = 0;
+    qsizetype m_blockStart = 0;
+    quint64 m_pendingSeparators = 0;
+    quint64 m_quoteCarry = 0;
+    qint64 m_recordCount = 0;
+    qint64 m_bytesRead = 0;
+    qint64 m_quoteCount = 0;
+    bool m_atEnd = false;
+};
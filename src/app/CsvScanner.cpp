@@ -0,0 +1,149 @@
+#include "CsvScanner.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINK2BOM_CSV_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define LINK2BOM_TARGET_AVX2
+#else
+#define LINK2BOM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace CsvScanner {
+namespace {
+BlockMasks scanBlockScalar(const char *block)
+{
+    return scanPartialBlock(block, BlockSize);
+}
+
+#ifdef LINK2BOM_CSV_X86
+quint64 movemask16(__m128i bytes, __m128i needle)
+{
+    return static_cast<quint16>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle)));
+}
+
+BlockMasks scanBlockSse2(const char *block)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    BlockMasks masks;
+    for (int lane = 0; lane < 4; ++lane) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + lane * 16));
+        const int shift = lane * 16;
+        masks.quotes |= movemask16(bytes, quote) << shift;
+        masks.commas |= movemask16(bytes, comma) << shift;
+        masks.newlines |= movemask16(bytes, newline) << shift;
+    }
+    return masks;
+}
+
+LINK2BOM_TARGET_AVX2 quint64 movemask32(__m256i bytes, __m256i needle)
+{
+    return static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, needle)));
+}
+
+LINK2BOM_TARGET_AVX2 BlockMasks scanBlockAvx2(const char *block)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    BlockMasks masks;
+    masks.quotes = movemask32(low, quote) | (movemask32(high, quote) << 32);
+    masks.commas = movemask32(low, comma) | (movemask32(high, comma) << 32);
+    masks.newlines = movemask32(low, newline) | (movemask32(high, newline) << 32);
+    return masks;
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+} // namespace
+
+Kernel bestKernel()
+{
+#ifdef LINK2BOM_CSV_X86
+    static const Kernel kernel = cpuHasAvx2() ? Kernel::Avx2 : Kernel::Sse2;
+    return kernel;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+const char *kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Avx2:
+        return "avx2";
+    case Kernel::Sse2:
+        return "sse2";
+    case Kernel::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+BlockFunction blockFunction(Kernel kernel)
+{
+#ifdef LINK2BOM_CSV_X86
+    if (kernel == Kernel::Avx2 && bestKernel() == Kernel::Avx2) {
+        return scanBlockAvx2;
+    }
+    if (kernel != Kernel::Scalar) {
+        return scanBlockSse2;
+    }
+#else
+    Q_UNUSED(kernel)
+#endif
+    return scanBlockScalar;
+}
+
+BlockMasks scanPartialBlock(const char *data, qsizetype size)
+{
+    BlockMasks masks;
+    const qsizetype count = qMin(size, BlockSize);
+    for (qsizetype i = 0; i < count; ++i) {
+        const quint64 bit = quint64(1) << i;
+        switch (data[i]) {
+        case '"':
+            masks.quotes |= bit;
+            break;
+        case ',':
+            masks.commas |= bit;
+            break;
+        case '\n':
+            masks.newlines |= bit;
+            break;
+        default:
+            break;
+        }
+    }
+    return masks;
+}
+
+} // namespace CsvScanner
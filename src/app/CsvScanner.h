@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QtGlobal>
+
+// Classifies 64-byte blocks of CSV input into bitmasks (bit i = byte i of the block).
+// Structural bytes are ASCII, so the masks are valid for UTF-8 and GBK/GB18030 input alike.
+namespace CsvScanner {
+
+constexpr qsizetype BlockSize = 64;
+
+struct BlockMasks {
+    quint64 quotes = 0;
+    quint64 commas = 0;
+    quint64 newlines = 0;
+};
+
+enum class Kernel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+using BlockFunction = BlockMasks (*)(const char *block);
+
+Kernel bestKernel();
+const char *kernelName(Kernel kernel);
+BlockFunction blockFunction(Kernel kernel);
+
+BlockMasks scanPartialBlock(const char *data, qsizetype size);
+
+// Bit i is set when byte i lies inside a quoted run, given the quote bits of the block.
+inline quint64 prefixXor(quint64 bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+} // namespace CsvScanner
@@ -1,27 +1,16 @@
 ﻿#include "DataIoController.h"
+#include "AppLogger.h"
+#include "HeaderMatcher.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QSettings>
 #include <QTextStream>
 #include <QSet>
 
-namespace {
-int findProjectColumn(const QStringList &headers)
-{
-    auto normalize = [](const QString &text) {
-        return QString(text).remove(' ').remove('\t').remove('\r').remove('\n').trimmed().toLower();
-    };
-    const QStringList keys = {QStringLiteral("项目"), QStringLiteral("project")};
-    for (int i = 0; i < headers.size(); ++i) {
-        const QString cell = normalize(headers[i]);
-        for (const QString &key : keys) {
-            if (cell.contains(key)) {
-                return i;
-            }
-        }
-    }
-    return -1;
-}
+#include <utility>
 
+namespace {
 QStringList collectProjects(const QList<QStringList> &rows, int projectIndex)
 {
     QSet<QString> unique;
@@ -37,6 +26,29 @@ QStringList collectProjects(const QList<QStringList> &rows, int projectIndex)
     list.sort();
     return list;
 }
+
+// Multiset difference: a row edited in place shows up once in each list.
+void diffRows(const QList<QStringList> &before, const QList<QStringList> &after,
+              QList<QStringList> *removed, QList<QStringList> *added)
+{
+    QHash<QStringList, int> unmatched;
+    for (const QStringList &row : before) {
+        unmatched[row] += 1;
+    }
+    for (const QStringList &row : after) {
+        const auto it = unmatched.find(row);
+        if (it != unmatched.end() && it.value() > 0) {
+            it.value() -= 1;
+        } else {
+            added->append(row);
+        }
+    }
+    for (auto it = unmatched.cbegin(); it != unmatched.cend(); ++it) {
+        for (int i = 0; i < it.value(); ++i) {
+            removed->append(it.key());
+        }
+    }
+}
 }
 
 DataIoController::DataIoController(ProjectController *projects, BomTableModel *bomModel, QObject *parent)
@@ -44,147 +56,225 @@ DataIoController::DataIoController(ProjectController *projects, BomTableModel *b
     , m_projects(projects)
     , m_bomModel(bomModel)
 {
+    constexpr qint64 MiB = 1024 * 1024;
+    QSettings settings;
+    const qint64 cacheMegabytes
+        = settings.value(QStringLiteral("importCache/maxMegabytes"), ImportCache::DefaultMaxBytes / MiB).toLongLong();
+    m_importCache.setMaxBytes(cacheMegabytes * MiB);
+    m_importService.setCache(&m_importCache);
+
+    // Editors and exporters often write a file in several bursts; apply them as one change.
+    m_linkDebounce.setSingleShot(true);
+    m_linkDebounce.setInterval(500);
+    connect(&m_linkWatcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path) {
+        m_pendingLinks.insert(path);
+        m_linkDebounce.start();
+    });
+    connect(&m_linkDebounce, &QTimer::timeout, this, [this]() {
+        const QSet<QString> paths = std::exchange(m_pendingLinks, {});
+        for (const QString &path : paths) {
+            refreshLinkedFile(path);
+        }
+    });
 }
 
-void DataIoController::importLichuang(const QUrl &fileUrl, const QString &projectName)
+DataIoController::~DataIoController()
 {
-    if (!m_projects || !m_bomModel) {
-        emit statusMessage(QStringLiteral("Import failed: data controller is not ready."));
-        return;
+    // The job refers to the import service; cancel and wait for it while both still exist.
+    delete m_importJob;
+}
+
+double DataIoController::importProgress() const
+{
+    if (!m_importJob || m_importJob->totalBytes() <= 0) {
+        return -1.0;
     }
+    return qBound(0.0, double(m_importJob->bytesRead()) / double(m_importJob->totalBytes()), 1.0);
+}
 
-    const QString localFile = fileUrl.toLocalFile();
-    if (localFile.isEmpty()) {
-        emit statusMessage(QStringLiteral("Import failed: please select a file."));
+qint64 DataIoController::importRowsParsed() const
+{
+    return m_importJob ? m_importJob->rowsParsed() : 0;
+}
+
+void DataIoController::importLichuang(const QUrl &fileUrl, const QString &projectName)
+{
+    QString localFile;
+    QString targetProject;
+    if (!beginImport(fileUrl, projectName, &localFile, &targetProject)) {
         return;
     }
 
-    const QString targetProject = projectName.trimmed();
-    if (targetProject.isEmpty() || targetProject == QStringLiteral("All Projects")) {
-        emit statusMessage(QStringLiteral("Import failed: please select a project."));
+    // Rows are mapped onto the current view's headers on the worker; if the view changed
+    // headers meanwhile, the append below refuses them instead of mixing layouts.
+    ImportJob *job = m_importService.startLichuangImport(localFile, targetProject, m_bomModel->availableHeaders(), this);
+    watchImport(job, [this, fileName = fileUrl.fileName(), targetProject](const ImportResult &result) {
+        if (!m_bomModel->appendRows(result.headers, result.rows, result.numericColumns)) {
+            emit statusMessage(QStringLiteral("Import failed: header mismatch with current BOM view. Import aborted to avoid overwriting existing data."));
+            return;
+        }
+        addImportedProjects(result);
+        emit statusMessage(QStringLiteral("Import complete: %1 -> %2.")
+                               .arg(fileName, selectImportedProject(result, targetProject)));
+    });
+}
+
+void DataIoController::importGeneric(const QUrl &fileUrl, const QString &projectName)
+{
+    QString localFile;
+    QString targetProject;
+    if (!beginImport(fileUrl, projectName, &localFile, &targetProject)) {
         return;
     }
 
-    m_projects->addProject(targetProject);
+    ImportJob *job = m_importService.startGenericImport(localFile, targetProject, this);
+    watchImport(job, [this, fileName = fileUrl.fileName(), targetProject](const ImportResult &result) {
+        const bool replaced = !m_bomModel->appendRows(result.headers, result.rows, result.numericColumns);
+        if (replaced) {
+            m_bomModel->setSourceData(result.headers, result.rows, result.numericColumns);
+        }
+        addImportedProjects(result);
+        const QString projects = selectImportedProject(result, targetProject);
+        emit statusMessage(replaced ? QStringLiteral("Import complete: BOM headers replaced to match template.")
+                                    : QStringLiteral("Import complete: %1 -> %2.").arg(fileName, projects));
+    });
+}
 
-    const ImportResult result = m_importService.importLichuangSpreadsheet(localFile, targetProject);
-    if (!result.ok) {
-        emit statusMessage(QStringLiteral("Import failed: %1").arg(result.error));
+void DataIoController::importBatch(const QList<QUrl> &fileUrls, bool lichuang)
+{
+    if (!m_projects || !m_bomModel) {
+        emit statusMessage(QStringLiteral("Import failed: data controller is not ready."));
+        return;
+    }
+    if (m_importJob) {
+        emit statusMessage(QStringLiteral("Import failed: another import is still running."));
         return;
     }
 
-    const int projectColumn = findProjectColumn(result.headers);
-    if (projectColumn >= 0) {
-        const QStringList imported = collectProjects(result.rows, projectColumn);
-        for (const QString &name : imported) {
-            m_projects->addProject(name);
+    QList<ImportService::BatchFile> files;
+    for (const QUrl &url : fileUrls) {
+        const QString localFile = url.toLocalFile();
+        if (!localFile.isEmpty()) {
+            files.append({localFile, QFileInfo(localFile).completeBaseName()});
         }
     }
+    if (files.isEmpty()) {
+        emit statusMessage(QStringLiteral("Import failed: please select a file."));
+        return;
+    }
 
-    if (!m_bomModel->appendRows(result.headers, result.rows)) {
-        const QStringList targetHeaders = m_bomModel->availableHeaders();
-        if (targetHeaders.isEmpty()) {
-            m_bomModel->setSourceData(result.headers, result.rows);
-        } else {
-            auto normalize = [](const QString &text) {
-                return QString(text).remove(' ').remove('\t').remove('\r').remove('\n').trimmed().toLower();
-            };
-            QVector<int> mapping;
-            mapping.reserve(targetHeaders.size());
-            int mappedCount = 0;
-            for (const QString &target : targetHeaders) {
-                const QString targetNorm = normalize(target);
-                int srcIndex = -1;
-                for (int i = 0; i < result.headers.size(); ++i) {
-                    const QString srcNorm = normalize(result.headers[i]);
-                    if (!targetNorm.isEmpty() && (srcNorm == targetNorm || srcNorm.contains(targetNorm) || targetNorm.contains(srcNorm))) {
-                        srcIndex = i;
-                        break;
-                    }
-                }
-                if (srcIndex >= 0) {
-                    mappedCount += 1;
-                }
-                mapping.append(srcIndex);
-            }
-
-            if (mappedCount == 0) {
-                emit statusMessage(QStringLiteral("Import failed: header mismatch with current BOM view. Import aborted to avoid overwriting existing data."));
-                return;
-            }
-
-            QList<QStringList> mappedRows;
-            mappedRows.reserve(result.rows.size());
-            for (const QStringList &row : result.rows) {
-                QStringList out;
-                out.reserve(targetHeaders.size());
-                for (int i = 0; i < targetHeaders.size(); ++i) {
-                    const int srcIndex = mapping[i];
-                    out.append(srcIndex >= 0 && srcIndex < row.size() ? row[srcIndex] : QString());
-                }
-                mappedRows.append(out);
-            }
-
-            if (!m_bomModel->appendRows(targetHeaders, mappedRows)) {
+    const QStringList targetHeaders = lichuang ? m_bomModel->availableHeaders() : QStringList();
+    ImportJob *job = m_importService.startBatchImport(files, lichuang, targetHeaders, this);
+    watchImport(job, [this, lichuang, fileCount = files.size()](const ImportResult &result) {
+        if (!m_bomModel->appendRows(result.headers, result.rows, result.numericColumns)) {
+            if (lichuang) {
                 emit statusMessage(QStringLiteral("Import failed: header mismatch with current BOM view. Import aborted to avoid overwriting existing data."));
                 return;
             }
+            m_bomModel->setSourceData(result.headers, result.rows, result.numericColumns);
+        }
+        addImportedProjects(result);
+        for (const QString &failure : result.failures) {
+            AppLogger::warn(QStringLiteral("Batch import skipped %1").arg(failure));
+        }
+        if (result.failures.isEmpty()) {
+            emit statusMessage(QStringLiteral("Import complete: %1 files.").arg(fileCount));
+        } else {
+            emit statusMessage(QStringLiteral("Import complete: %1 of %2 files. Failed: %3")
+                                   .arg(fileCount - result.failures.size())
+                                   .arg(fileCount)
+                                   .arg(result.failures.join(QStringLiteral("; "))));
         }
+        m_projects->setSelectedProject(QStringLiteral("All Projects"));
+    });
+}
+
+QVariantMap DataIoController::previewImport(const QUrl &fileUrl, bool lichuang, const QString &projectName) const
+{
+    QVariantMap map;
+    const QString localFile = fileUrl.toLocalFile();
+    if (localFile.isEmpty() || !m_bomModel) {
+        map.insert(QStringLiteral("ok"), false);
+        map.insert(QStringLiteral("error"), QStringLiteral("Please select a file."));
+        return map;
     }
 
-    emit statusMessage(QStringLiteral("Import complete: %1 -> %2.").arg(fileUrl.fileName(), targetProject));
+    const ImportPreview preview
+        = m_importService.previewImport(localFile, lichuang, projectName, m_bomModel->availableHeaders());
+    QVariantList rows;
+    rows.reserve(preview.sample.rows.size());
+    for (const QStringList &row : preview.sample.rows) {
+        rows.append(row);
+    }
+    map.insert(QStringLiteral("ok"), preview.sample.ok);
+    map.insert(QStringLiteral("error"), preview.sample.error);
+    map.insert(QStringLiteral("headers"), preview.sample.headers);
+    map.insert(QStringLiteral("sourceHeaders"), preview.sourceHeaders);
+    map.insert(QStringLiteral("rows"), rows);
+    map.insert(QStringLiteral("headerConfidence"), preview.sample.headerConfidence);
+    map.insert(QStringLiteral("fitsView"), preview.fitsView);
+    return map;
+}
 
-    if (!targetProject.isEmpty()) {
-        m_projects->setSelectedProject(targetProject);
+void DataIoController::cancelImport()
+{
+    if (m_importJob) {
+        m_importJob->cancel();
+        emit statusMessage(QStringLiteral("Canceling import..."));
     }
 }
 
-void DataIoController::importGeneric(const QUrl &fileUrl, const QString &projectName)
+bool DataIoController::beginImport(const QUrl &fileUrl, const QString &projectName, QString *localFile,
+                                   QString *targetProject)
 {
     if (!m_projects || !m_bomModel) {
         emit statusMessage(QStringLiteral("Import failed: data controller is not ready."));
-        return;
+        return false;
+    }
+    if (m_importJob) {
+        emit statusMessage(QStringLiteral("Import failed: another import is still running."));
+        return false;
     }
 
-    const QString localFile = fileUrl.toLocalFile();
-    if (localFile.isEmpty()) {
+    *localFile = fileUrl.toLocalFile();
+    if (localFile->isEmpty()) {
         emit statusMessage(QStringLiteral("Import failed: please select a file."));
-        return;
+        return false;
     }
 
-    const QString targetProject = projectName.trimmed();
-    if (targetProject.isEmpty() || targetProject == QStringLiteral("All Projects")) {
+    *targetProject = projectName.trimmed();
+    if (targetProject->isEmpty() || *targetProject == QStringLiteral("All Projects")) {
         emit statusMessage(QStringLiteral("Import failed: please select a project."));
-        return;
-    }
-
-    m_projects->addProject(targetProject);
-
-    const ImportResult result = m_importService.importGenericSpreadsheet(localFile, targetProject);
-    if (!result.ok) {
-        emit statusMessage(QStringLiteral("Import failed: %1").arg(result.error));
-        return;
+        return false;
     }
+    return true;
+}
 
-    const int projectColumn = findProjectColumn(result.headers);
-    if (projectColumn >= 0) {
-        const QStringList imported = collectProjects(result.rows, projectColumn);
-        for (const QString &name : imported) {
-            m_projects->addProject(name);
+void DataIoController::watchImport(ImportJob *job, std::function<void(const ImportResult &)> apply,
+                                   const QString &action)
+{
+    m_importJob = job;
+    connect(job, &ImportJob::progressChanged, this, &DataIoController::importStateChanged);
+    connect(job, &ImportJob::finished, this, [this, job, apply = std::move(apply), action]() {
+        m_importJob = nullptr;
+        job->deleteLater();
+        emit importStateChanged();
+
+        const ImportResult &result = job->result();
+        if (!result.ok) {
+            emit statusMessage(job->isCanceled() ? QStringLiteral("%1 canceled.").arg(action)
+                                                 : QStringLiteral("%1 failed: %2").arg(action, result.error));
+        } else {
+            apply(result);
         }
-    }
-
-    if (!m_bomModel->appendRows(result.headers, result.rows)) {
-        m_bomModel->setSourceData(result.headers, result.rows);
-        emit statusMessage(QStringLiteral("Import complete: BOM headers replaced to match template."));
-    } else {
-        emit statusMessage(QStringLiteral("Import complete: %1 -> %2.").arg(fileUrl.fileName(), targetProject));
-    }
-
-    if (!targetProject.isEmpty()) {
-        m_projects->setSelectedProject(targetProject);
-    }
+        // Linked files that changed while this job ran are picked up now.
+        if (!m_pendingLinks.isEmpty()) {
+            m_linkDebounce.start();
+        }
+    });
+    emit importStateChanged();
 }
+
 bool DataIoController::exportCsv(const QUrl &fileUrl)
 {
     if (!m_bomModel) {
@@ -240,3 +330,175 @@ bool DataIoController::exportCsv(const QUrl &fileUrl)
     return true;
 }
 
+bool DataIoController::linkLichuang(const QUrl &fileUrl, const QString &projectName)
+{
+    if (!m_projects || !m_bomModel) {
+        emit statusMessage(QStringLiteral("Link failed: data controller is not ready."));
+        return false;
+    }
+
+    const QString localFile = fileUrl.toLocalFile();
+    if (localFile.isEmpty()) {
+        emit statusMessage(QStringLiteral("Link failed: please select a file."));
+        return false;
+    }
+    if (m_links.contains(localFile)) {
+        emit statusMessage(QStringLiteral("Link skipped: %1 is already linked.").arg(fileUrl.fileName()));
+        return false;
+    }
+
+    const QString targetProject = projectName.trimmed();
+    if (targetProject.isEmpty() || targetProject == QStringLiteral("All Projects")) {
+        emit statusMessage(QStringLiteral("Link failed: please select a project."));
+        return false;
+    }
+
+    if (m_importJob) {
+        emit statusMessage(QStringLiteral("Link failed: another import is still running."));
+        return false;
+    }
+
+    auto state = std::make_shared<ImportService::LinkState>();
+    ImportJob *job = m_importService.startLinkedImport(localFile, targetProject, state, this);
+    const QFileInfo info(localFile);
+    watchImport(job, [this, state, localFile, targetProject, fileName = fileUrl.fileName(), size = info.size(),
+                      modified = info.lastModified()](const ImportResult &result) {
+        // Linked rows are diffed against what the model holds, so they must not be remapped.
+        if (!m_bomModel->appendRows(result.headers, result.rows, result.numericColumns)) {
+            if (!m_bomModel->availableHeaders().isEmpty()) {
+                emit statusMessage(QStringLiteral("Link failed: header mismatch with current BOM view."));
+                return;
+            }
+            m_bomModel->setSourceData(result.headers, result.rows, result.numericColumns);
+        }
+
+        addImportedProjects(result);
+
+        LinkedImport link;
+        link.project = targetProject;
+        link.size = size;
+        link.modified = modified;
+        link.resume = state->resume;
+        link.headers = result.headers;
+        link.rows = result.rows;
+        m_links.insert(localFile, link);
+        m_linkWatcher.addPath(localFile);
+        emit linkedFilesChanged();
+
+        emit statusMessage(QStringLiteral("Linked: %1 -> %2.").arg(fileName, selectImportedProject(result, targetProject)));
+    }, QStringLiteral("Link"));
+    return true;
+}
+
+void DataIoController::unlinkFile(const QUrl &fileUrl)
+{
+    const QString localFile = fileUrl.toLocalFile();
+    if (!m_links.remove(localFile)) {
+        return;
+    }
+    m_linkWatcher.removePath(localFile);
+    m_pendingLinks.remove(localFile);
+    emit linkedFilesChanged();
+}
+
+QStringList DataIoController::linkedFiles() const
+{
+    QStringList files = m_links.keys();
+    files.sort();
+    return files;
+}
+
+void DataIoController::addImportedProjects(const ImportResult &result)
+{
+    const int projectColumn = HeaderMatcher::projectColumn().findColumn(result.headers, 0);
+    if (projectColumn >= 0) {
+        m_projects->addProjects(collectProjects(result.rows, projectColumn));
+    }
+}
+
+QString DataIoController::selectImportedProject(const ImportResult &result, const QString &targetProject)
+{
+    // A workbook or bundle with several parts fills projects named after them instead; the
+    // target project would stay empty, so it is not created.
+    if (result.projects.isEmpty()) {
+        m_projects->addProject(targetProject);
+        m_projects->setSelectedProject(targetProject);
+        return targetProject;
+    }
+    m_projects->addProjects(result.projects);
+    m_projects->setSelectedProject(result.projects.size() == 1 ? result.projects.first() : QStringLiteral("All Projects"));
+    return result.projects.join(QStringLiteral(", "));
+}
+
+void DataIoController::refreshLinkedFile(const QString &path)
+{
+    const auto linkIt = m_links.find(path);
+    if (linkIt == m_links.end() || !m_bomModel) {
+        return;
+    }
+    LinkedImport &link = linkIt.value();
+
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        emit statusMessage(QStringLiteral("Linked file is missing: %1").arg(info.fileName()));
+        return;
+    }
+    // Saving by rename replaces the inode and drops it from the watcher.
+    if (!m_linkWatcher.files().contains(path)) {
+        m_linkWatcher.addPath(path);
+    }
+    if (info.size() == link.size && info.lastModified() == link.modified) {
+        return;
+    }
+
+    if (m_importJob) {
+        m_pendingLinks.insert(path);
+        return;
+    }
+
+    auto state = std::make_shared<ImportService::LinkState>();
+    state->resume = link.resume;
+    ImportJob *job = m_importService.startLinkedImport(path, link.project, state, this);
+    watchImport(job, [this, state, path, fileName = info.fileName(), size = info.size(),
+                      modified = info.lastModified()](const ImportResult &result) {
+        const auto linkIt = m_links.find(path);
+        if (linkIt == m_links.end()) {
+            return;
+        }
+        LinkedImport &link = linkIt.value();
+        // Another import may have replaced the view's headers since; rows of the old layout
+        // would land in the wrong columns and the diff would miss the rows it expects.
+        if (m_bomModel->availableHeaders() != link.headers) {
+            m_links.erase(linkIt);
+            m_linkWatcher.removePath(path);
+            m_pendingLinks.remove(path);
+            emit linkedFilesChanged();
+            emit statusMessage(QStringLiteral("Linked file unlinked: %1 no longer matches the BOM view's headers.").arg(fileName));
+            return;
+        }
+
+        if (state->appendedOnly) {
+            if (!result.rows.isEmpty()) {
+                m_bomModel->replaceRows({}, result.rows);
+                link.rows.append(result.rows);
+                addImportedProjects(result);
+            }
+            emit statusMessage(QStringLiteral("Linked file updated: %1 (+%2 rows).").arg(fileName).arg(result.rows.size()));
+        } else {
+            QList<QStringList> removed;
+            QList<QStringList> added;
+            diffRows(link.rows, result.rows, &removed, &added);
+            m_bomModel->replaceRows(removed, added);
+            link.rows = result.rows;
+            addImportedProjects(result);
+            emit statusMessage(QStringLiteral("Linked file updated: %1 (+%2 / -%3 rows).")
+                                   .arg(fileName)
+                                   .arg(added.size())
+                                   .arg(removed.size()));
+        }
+
+        link.resume = state->resume;
+        link.size = size;
+        link.modified = modified;
+    }, QStringLiteral("Linked file update"));
+}
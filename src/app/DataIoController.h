@@ -1,7 +1,15 @@
 ﻿#pragma once
 
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
 #include <QObject>
+#include <QSet>
+#include <QTimer>
 #include <QUrl>
+#include <QVariantMap>
+
+#include <functional>
 
 #include "BomTableModel.h"
 #include "ImportService.h"
@@ -10,20 +18,73 @@
 class DataIoController : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool importing READ importing NOTIFY importStateChanged)
+    // Share of the source read so far, or -1 while that is unknown (a converter is running).
+    Q_PROPERTY(double importProgress READ importProgress NOTIFY importStateChanged)
+    Q_PROPERTY(qint64 importRowsParsed READ importRowsParsed NOTIFY importStateChanged)
 
 public:
     explicit DataIoController(ProjectController *projects, BomTableModel *bomModel, QObject *parent = nullptr);
+    ~DataIoController() override;
+
+    bool importing() const { return m_importJob != nullptr; }
+    double importProgress() const;
+    qint64 importRowsParsed() const;
 
+    // Imports run on worker threads one at a time; the result reaches the model when done.
     Q_INVOKABLE void importLichuang(const QUrl &fileUrl, const QString &projectName);
     Q_INVOKABLE void importGeneric(const QUrl &fileUrl, const QString &projectName);
+    // Imports many files in one job, each into a project named after the file. All rows reach
+    // the model in one update; files that fail are reported without stopping the rest.
+    Q_INVOKABLE void importBatch(const QList<QUrl> &fileUrls, bool lichuang);
+    Q_INVOKABLE void cancelImport();
+    // Shapes the first rows of a file the way the import would, without importing it: ok,
+    // error, headers, sourceHeaders (where each header is read from), rows, headerConfidence
+    // and fitsView (false when the import would be refused or replace the view's headers).
+    Q_INVOKABLE QVariantMap previewImport(const QUrl &fileUrl, bool lichuang, const QString &projectName) const;
     Q_INVOKABLE bool exportCsv(const QUrl &fileUrl);
 
+    // Imports an LCSC file and keeps it linked: later changes on disk are applied as the rows
+    // they add or change, instead of a second full import. Both run as import jobs; changes
+    // seen while another import runs are applied after it.
+    Q_INVOKABLE bool linkLichuang(const QUrl &fileUrl, const QString &projectName);
+    Q_INVOKABLE void unlinkFile(const QUrl &fileUrl);
+    Q_INVOKABLE QStringList linkedFiles() const;
+
 signals:
     void statusMessage(const QString &message);
+    void linkedFilesChanged();
+    void importStateChanged();
 
 private:
+    struct LinkedImport {
+        QString project;
+        qint64 size = -1;
+        QDateTime modified;
+        CsvResumeState resume;
+        // The header layout the rows were linked under; refreshes apply only while the view has it.
+        QStringList headers;
+        QList<QStringList> rows;
+    };
+
+    bool beginImport(const QUrl &fileUrl, const QString &projectName, QString *localFile, QString *targetProject);
+    // action names the job in its failure and cancel messages.
+    void watchImport(ImportJob *job, std::function<void(const ImportResult &)> apply,
+                     const QString &action = QStringLiteral("Import"));
+    void addImportedProjects(const ImportResult &result);
+    // Creates the project a single-part import went to and selects where the rows landed.
+    // Returns the name(s) for the status message.
+    QString selectImportedProject(const ImportResult &result, const QString &targetProject);
+    void refreshLinkedFile(const QString &path);
+
     ProjectController *m_projects = nullptr;
     BomTableModel *m_bomModel = nullptr;
+    ImportCache m_importCache;
     ImportService m_importService;
+    ImportJob *m_importJob = nullptr;
+    QFileSystemWatcher m_linkWatcher;
+    QTimer m_linkDebounce;
+    QSet<QString> m_pendingLinks;
+    QHash<QString, LinkedImport> m_links;
 };
 
@@ -0,0 +1,66 @@
+#include "FixedDecimal.h"
+
+#include <limits>
+
+FixedDecimal FixedDecimal::fromText(QStringView text)
+{
+    constexpr int Decimals = 6;
+    constexpr qint64 MaxWhole = std::numeric_limits<qint64>::max() / Scale - 1;
+
+    bool negative = false;
+    bool seenPoint = false;
+    bool seenDigit = false;
+    bool seenSign = false;
+    bool roundUp = false;
+    qint64 whole = 0;
+    qint64 fraction = 0;
+    int fractionDigits = 0;
+
+    for (const QChar ch : text) {
+        const char16_t c = ch.unicode();
+        if (c >= u'0' && c <= u'9') {
+            const int digit = c - u'0';
+            seenDigit = true;
+            if (!seenPoint) {
+                whole = whole * 10 + digit;
+                if (whole > MaxWhole) {
+                    return {};
+                }
+            } else if (fractionDigits < Decimals) {
+                fraction = fraction * 10 + digit;
+                ++fractionDigits;
+            } else if (fractionDigits == Decimals) {
+                roundUp = digit >= 5;
+                ++fractionDigits;
+            }
+        } else if (c == u'.') {
+            if (seenPoint) {
+                return {};
+            }
+            seenPoint = true;
+        } else if (c == u'-') {
+            // Only a single leading sign is a number; "1-2" or "--1" are not.
+            if (seenSign || seenDigit || seenPoint) {
+                return {};
+            }
+            seenSign = true;
+            negative = true;
+        }
+    }
+
+    if (!seenDigit) {
+        return {};
+    }
+
+    for (int i = qMin(fractionDigits, Decimals); i < Decimals; ++i) {
+        fraction *= 10;
+    }
+
+    FixedDecimal value;
+    value.m_raw = whole * Scale + fraction + (roundUp ? 1 : 0);
+    if (negative) {
+        value.m_raw = -value.m_raw;
+    }
+    value.m_valid = true;
+    return value;
+}
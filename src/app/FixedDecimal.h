@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QStringView>
+
+// Signed fixed-point number with six decimal places, read from spreadsheet cells such as
+// "1,234.50", "¥0.0123" or "100pcs": every character other than digits, '.' and '-' is
+// ignored. Empty or malformed cells stay invalid instead of reading as zero.
+class FixedDecimal
+{
+public:
+    static constexpr qint64 Scale = 1000000;
+
+    FixedDecimal() = default;
+
+    static FixedDecimal fromText(QStringView text);
+
+    bool isValid() const { return m_valid; }
+    qint64 raw() const { return m_raw; }
+    double toDouble() const { return double(m_raw) / Scale; }
+
+    // Invalid values order before every valid one.
+    friend bool operator<(const FixedDecimal &a, const FixedDecimal &b)
+    {
+        return a.m_valid != b.m_valid ? !a.m_valid : a.m_raw < b.m_raw;
+    }
+    friend bool operator==(const FixedDecimal &a, const FixedDecimal &b)
+    {
+        return a.m_valid == b.m_valid && a.m_raw == b.m_raw;
+    }
+
+private:
+    qint64 m_raw = 0;
+    bool m_valid = false;
+};
@@ -0,0 +1,154 @@
+#include "HeaderMatcher.h"
+
+#include <QtAlgorithms>
+
+namespace {
+bool isSkipped(QChar ch)
+{
+    return ch == u' ' || ch == u'\t' || ch == u'\r' || ch == u'\n';
+}
+}
+
+HeaderMatcher::HeaderMatcher(const QList<QStringList> &fieldKeys)
+    : m_fieldCount(static_cast<int>(qMin<qsizetype>(fieldKeys.size(), 32)))
+{
+    m_nodes.append(Node());
+
+    for (int field = 0; field < m_fieldCount; ++field) {
+        for (const QString &key : fieldKeys[field]) {
+            int state = 0;
+            bool empty = true;
+            for (const QChar ch : key) {
+                if (isSkipped(ch)) {
+                    continue;
+                }
+                const char16_t folded = ch.toCaseFolded().unicode();
+                int next = child(state, folded);
+                if (next < 0) {
+                    next = static_cast<int>(m_nodes.size());
+                    m_nodes[state].edges.append({folded, next});
+                    m_nodes.append(Node());
+                }
+                state = next;
+                empty = false;
+            }
+            if (!empty) {
+                m_nodes[state].fields |= quint32(1) << field;
+            }
+        }
+    }
+
+    // Breadth-first failure links; a node also reports every key that ends at its fail target.
+    QList<int> queue;
+    for (const Edge &edge : m_nodes[0].edges) {
+        queue.append(edge.target);
+    }
+    for (qsizetype head = 0; head < queue.size(); ++head) {
+        const int state = queue[head];
+        for (const Edge &edge : m_nodes[state].edges) {
+            const int fail = step(m_nodes[state].fail, edge.ch);
+            m_nodes[edge.target].fail = fail;
+            m_nodes[edge.target].fields |= m_nodes[fail].fields;
+            queue.append(edge.target);
+        }
+    }
+}
+
+const HeaderMatcher &HeaderMatcher::lichuangColumns()
+{
+    static const HeaderMatcher matcher({
+        {QStringLiteral("\u5546\u54c1\u7f16\u53f7"), QStringLiteral("\u6599\u53f7"),
+         QStringLiteral("item"), QStringLiteral("part"), QStringLiteral("lcsc")},
+        {QStringLiteral("\u54c1\u724c"), QStringLiteral("brand")},
+        {QStringLiteral("\u5382\u5bb6\u578b\u53f7"), QStringLiteral("\u578b\u53f7"),
+         QStringLiteral("mpn"), QStringLiteral("manufacturer")},
+        {QStringLiteral("\u5c01\u88c5"), QStringLiteral("package")},
+        {QStringLiteral("\u5546\u54c1\u540d\u79f0"), QStringLiteral("\u63cf\u8ff0"),
+         QStringLiteral("name"), QStringLiteral("description")},
+        {QStringLiteral("\u8ba2\u8d2d\u6570\u91cf"), QStringLiteral("\u6570\u91cf"),
+         QStringLiteral("qty"), QStringLiteral("quantity")},
+        {QStringLiteral("\u5546\u54c1\u5355\u4ef7"), QStringLiteral("\u5355\u4ef7"),
+         QStringLiteral("unit"), QStringLiteral("price")},
+        {QStringLiteral("\u5546\u54c1\u91d1\u989d"), QStringLiteral("\u91d1\u989d"),
+         QStringLiteral("amount"), QStringLiteral("total")},
+    });
+    return matcher;
+}
+
+const HeaderMatcher &HeaderMatcher::projectColumn()
+{
+    static const HeaderMatcher matcher({{QStringLiteral("\u9879\u76ee"), QStringLiteral("project")}});
+    return matcher;
+}
+
+int HeaderMatcher::fieldCount() const
+{
+    return m_fieldCount;
+}
+
+quint32 HeaderMatcher::match(QStringView text) const
+{
+    quint32 fields = 0;
+    int state = 0;
+    for (const QChar ch : text) {
+        if (isSkipped(ch)) {
+            continue;
+        }
+        state = step(state, ch.toCaseFolded().unicode());
+        fields |= m_nodes[state].fields;
+    }
+    return fields;
+}
+
+int HeaderMatcher::findColumn(const QStringList &cells, int field, int fallbackIndex) const
+{
+    const quint32 bit = quint32(1) << field;
+    for (int i = 0; i < cells.size(); ++i) {
+        if (match(cells[i]) & bit) {
+            return i;
+        }
+    }
+    return fallbackIndex;
+}
+
+HeaderMatcher::Detection HeaderMatcher::score(const QList<quint32> &cellMatches) const
+{
+    Detection detection;
+    detection.columns.fill(-1, m_fieldCount);
+    for (int i = 0; i < cellMatches.size(); ++i) {
+        quint32 fresh = cellMatches[i] & ~detection.fields;
+        detection.fields |= fresh;
+        while (fresh) {
+            detection.columns[qCountTrailingZeroBits(fresh)] = i;
+            fresh &= fresh - 1;
+        }
+    }
+    if (m_fieldCount > 0) {
+        detection.confidence = double(qPopulationCount(detection.fields)) / m_fieldCount;
+    }
+    return detection;
+}
+
+int HeaderMatcher::child(int state, char16_t ch) const
+{
+    for (const Edge &edge : m_nodes[state].edges) {
+        if (edge.ch == ch) {
+            return edge.target;
+        }
+    }
+    return -1;
+}
+
+int HeaderMatcher::step(int state, char16_t ch) const
+{
+    for (;;) {
+        const int next = child(state, ch);
+        if (next >= 0) {
+            return next;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = m_nodes[state].fail;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QList>
+#include <QStringList>
+#include <QStringView>
+#include <QVarLengthArray>
+
+// Finds which fields a spreadsheet header cell names. The keys of all fields are compiled
+// into one Aho-Corasick automaton over case-folded UTF-16, so a single pass over a cell
+// reports every field whose key occurs in it. Spaces, tabs and line breaks in the input are
+// skipped, as the import code has always normalised header text.
+class HeaderMatcher
+{
+public:
+    enum LichuangField {
+        ItemCode,
+        Brand,
+        Model,
+        Package,
+        Name,
+        Qty,
+        UnitPrice,
+        Amount,
+        LichuangFieldCount
+    };
+
+    // Result of scoring one candidate row: columns[field] is the first cell naming the field
+    // (or -1), confidence the share of all fields that were found.
+    struct Detection {
+        QList<int> columns;
+        quint32 fields = 0;
+        double confidence = 0.0;
+
+        bool covers(quint32 required) const { return (fields & required) == required; }
+    };
+
+    // fieldKeys[i] lists the keys of field i; at most 32 fields.
+    explicit HeaderMatcher(const QList<QStringList> &fieldKeys);
+
+    static const HeaderMatcher &lichuangColumns();
+    static const HeaderMatcher &projectColumn();
+
+    int fieldCount() const;
+    quint32 match(QStringView text) const;
+    int findColumn(const QStringList &cells, int field, int fallbackIndex = -1) const;
+    Detection score(const QList<quint32> &cellMatches) const;
+
+private:
+    struct Edge {
+        char16_t ch = 0;
+        int target = 0;
+    };
+
+    struct Node {
+        QVarLengthArray<Edge, 4> edges;
+        int fail = 0;
+        quint32 fields = 0;
+    };
+
+    int child(int state, char16_t ch) const;
+    int step(int state, char16_t ch) const;
+
+    QList<Node> m_nodes;
+    int m_fieldCount = 0;
+};
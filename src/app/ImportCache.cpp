@@ -0,0 +1,179 @@
+#include "ImportCache.h"
+
+#include "AppLogger.h"
+#include "AppPaths.h"
+#include "XxHash64.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <utility>
+
+namespace {
+constexpr quint32 EntryMagic = 0x4C324243; // "L2BC"
+constexpr quint16 EntryVersion = 3;
+constexpr qint64 HashChunkSize = qint64(1) << 20;
+
+QString entrySuffix()
+{
+    return QStringLiteral(".l2bc");
+}
+} // namespace
+
+ImportCache::ImportCache(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+QString ImportCache::defaultDirectory()
+{
+    return QDir(AppPaths::dataDir()).filePath(QStringLiteral("import_cache"));
+}
+
+ImportCache::Fingerprint ImportCache::fingerprint(const QString &filePath)
+{
+    Fingerprint result;
+    const QFileInfo info(filePath);
+    QFile file(filePath);
+    if (!info.isFile() || !file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    XxHash64 hash;
+    if (const uchar *data = file.size() > 0 ? file.map(0, file.size()) : nullptr) {
+        hash.add(QByteArrayView(reinterpret_cast<const char *>(data), file.size()));
+        file.unmap(const_cast<uchar *>(data));
+    } else {
+        QByteArray chunk;
+        while (!(chunk = file.read(HashChunkSize)).isEmpty()) {
+            hash.add(chunk);
+        }
+        if (file.error() != QFileDevice::NoError) {
+            return result;
+        }
+    }
+
+    result.path = info.absoluteFilePath();
+    result.size = info.size();
+    result.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+    result.contentHash = hash.digest();
+    return result;
+}
+
+void ImportCache::setMaxBytes(qint64 bytes)
+{
+    m_maxBytes = qMax<qint64>(0, bytes);
+}
+
+bool ImportCache::lookup(const Fingerprint &source, Parser parser, const QString &projectName, ImportResult *result) const
+{
+    if (!source.isValid() || m_maxBytes == 0) {
+        return false;
+    }
+
+    const QString path = entryPath(source.path, parser, projectName);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    file.close();
+
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_6_5);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 revision = 0;
+    in >> magic >> version >> revision;
+    if (magic != EntryMagic || version != EntryVersion || revision != ParserRevision) {
+        return false;
+    }
+
+    QString storedPath;
+    QString storedProject;
+    quint8 storedParser = 0;
+    qint64 size = -1;
+    qint64 modifiedMs = 0;
+    quint64 contentHash = 0;
+    in >> storedPath >> storedParser >> storedProject >> size >> modifiedMs >> contentHash;
+    if (storedPath != source.path || storedParser != quint8(parser) || storedProject != projectName
+        || size != source.size || modifiedMs != source.modifiedMs || contentHash != source.contentHash) {
+        return false;
+    }
+
+    ImportResult cached;
+    in >> cached.headers >> cached.headerConfidence >> cached.numericColumns >> cached.rows >> cached.failures >> cached.projects;
+    if (in.status() != QDataStream::Ok) {
+        AppLogger::warn(QStringLiteral("Import cache entry is corrupt, ignoring: %1").arg(path));
+        QFile::remove(path);
+        return false;
+    }
+
+    // Touching the entry keeps it at the young end of the eviction order.
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+
+    cached.ok = true;
+    *result = std::move(cached);
+    return true;
+}
+
+void ImportCache::store(const Fingerprint &source, Parser parser, const QString &projectName, const ImportResult &result) const
+{
+    if (!source.isValid() || !result.ok || m_maxBytes == 0) {
+        return;
+    }
+    if (!QDir().mkpath(m_directory)) {
+        AppLogger::warn(QStringLiteral("Cannot create import cache directory: %1").arg(m_directory));
+        return;
+    }
+
+    QSaveFile file(entryPath(source.path, parser, projectName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        AppLogger::warn(QStringLiteral("Cannot write import cache entry: %1").arg(file.fileName()));
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << EntryMagic << EntryVersion << ParserRevision;
+    out << source.path << quint8(parser) << projectName << source.size << source.modifiedMs << source.contentHash;
+    out << result.headers << result.headerConfidence << result.numericColumns << result.rows << result.failures << result.projects;
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        AppLogger::warn(QStringLiteral("Cannot write import cache entry: %1").arg(file.fileName()));
+        return;
+    }
+
+    evict();
+}
+
+QString ImportCache::entryPath(const QString &sourcePath, Parser parser, const QString &projectName) const
+{
+    // One slot per (path, parser, project): a changed file overwrites its old entry.
+    const QByteArray key = sourcePath.toUtf8() + '\0' + char(parser) + projectName.toUtf8();
+    return QDir(m_directory).filePath(QString::number(XxHash64::hash(key), 16).rightJustified(16, QLatin1Char('0'))
+                                      + entrySuffix());
+}
+
+void ImportCache::evict() const
+{
+    const QFileInfoList entries = QDir(m_directory).entryInfoList({QStringLiteral("*") + entrySuffix()}, QDir::Files,
+                                                                  QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo &entry : entries) {
+        total += entry.size();
+    }
+
+    // QDir::Time lists the most recently used entries first.
+    for (auto it = entries.crbegin(); it != entries.crend() && total > m_maxBytes; ++it) {
+        if (QFile::remove(it->absoluteFilePath())) {
+            total -= it->size();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QString>
+
+#include "ImportTypes.h"
+
+// On-disk cache of parsed imports under <data>/import_cache. An entry is keyed by the source
+// path, parser and project, and is only reused while the file's size, modification time and
+// XXH64 content hash and the parser revision are unchanged, so a repeat import is one
+// sequential read instead of a conversion and parse. Entries are evicted least recently used once the total exceeds
+// maxBytes().
+class ImportCache
+{
+public:
+    enum class Parser : quint8 {
+        Lichuang = 1,
+        Generic = 2
+    };
+
+    struct Fingerprint {
+        QString path;
+        qint64 size = -1;
+        qint64 modifiedMs = 0;
+        quint64 contentHash = 0;
+
+        bool isValid() const { return size >= 0; }
+        bool sameContent(const Fingerprint &other) const
+        {
+            return isValid() && path == other.path && size == other.size && modifiedMs == other.modifiedMs
+                && contentHash == other.contentHash;
+        }
+    };
+
+    static constexpr qint64 DefaultMaxBytes = qint64(256) * 1024 * 1024;
+    // Stored in every entry; entries from another revision are ignored. Bump it with any parser
+    // change that alters what importing the same file produces.
+    static constexpr quint32 ParserRevision = 1;
+
+    explicit ImportCache(const QString &directory = defaultDirectory());
+
+    static QString defaultDirectory();
+    // Reads and hashes the file; returns an invalid fingerprint when it cannot be read.
+    static Fingerprint fingerprint(const QString &filePath);
+
+    qint64 maxBytes() const { return m_maxBytes; }
+    void setMaxBytes(qint64 bytes);
+
+    bool lookup(const Fingerprint &source, Parser parser, const QString &projectName, ImportResult *result) const;
+    void store(const Fingerprint &source, Parser parser, const QString &projectName, const ImportResult &result) const;
+
+private:
+    QString entryPath(const QString &sourcePath, Parser parser, const QString &projectName) const;
+    void evict() const;
+
+    QString m_directory;
+    qint64 m_maxBytes = DefaultMaxBytes;
+};
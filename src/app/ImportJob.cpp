@@ -0,0 +1,48 @@
+#include "ImportJob.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <utility>
+
+namespace {
+constexpr int ProgressIntervalMs = 100;
+}
+
+ImportJob::ImportJob(Work work, QObject *parent)
+    : QObject(parent)
+{
+    m_progressTimer.setInterval(ProgressIntervalMs);
+    connect(&m_progressTimer, &QTimer::timeout, this, &ImportJob::sampleProgress);
+    connect(&m_watcher, &QFutureWatcher<ImportResult>::finished, this, [this]() {
+        m_progressTimer.stop();
+        sampleProgress();
+        m_result = m_watcher.result();
+        m_finished = true;
+        emit finished();
+    });
+
+    m_watcher.setFuture(QtConcurrent::run([this, work = std::move(work)]() { return work(&m_monitor); }));
+    m_progressTimer.start();
+}
+
+ImportJob::~ImportJob()
+{
+    m_monitor.cancel();
+    m_watcher.waitForFinished();
+}
+
+void ImportJob::cancel()
+{
+    m_monitor.cancel();
+}
+
+void ImportJob::sampleProgress()
+{
+    const qint64 bytes = m_monitor.bytesRead();
+    const qint64 rows = m_monitor.rowsParsed();
+    if (bytes != m_sampledBytes || rows != m_sampledRows) {
+        m_sampledBytes = bytes;
+        m_sampledRows = rows;
+        emit progressChanged();
+    }
+}
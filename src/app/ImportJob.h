@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+
+#include "ImportTypes.h"
+
+// One import running on the global thread pool. The job lives on the thread that created it
+// (the GUI thread): progress is sampled from the shared monitor by a timer there and
+// finished() is emitted there, so handlers may touch models directly.
+class ImportJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Work = std::function<ImportResult(ImportMonitor *monitor)>;
+
+    // Starts work right away.
+    explicit ImportJob(Work work, QObject *parent = nullptr);
+    // Cancels and waits, so the work never outlives what it refers to.
+    ~ImportJob() override;
+
+    // Kills a running converter and stops the parse at its next checkpoint; finished() still
+    // follows, with a failed result unless the work had already completed.
+    void cancel();
+    bool isCanceled() const { return m_monitor.isCanceled(); }
+    bool isFinished() const { return m_finished; }
+    // Valid once finished() was emitted.
+    const ImportResult &result() const { return m_result; }
+
+    // 0 while the total is unknown (a conversion is still running).
+    qint64 totalBytes() const { return m_monitor.totalBytes(); }
+    qint64 bytesRead() const { return m_monitor.bytesRead(); }
+    qint64 rowsParsed() const { return m_monitor.rowsParsed(); }
+
+signals:
+    void progressChanged();
+    void finished();
+
+private:
+    void sampleProgress();
+
+    ImportMonitor m_monitor;
+    QFutureWatcher<ImportResult> m_watcher;
+    QTimer m_progressTimer;
+    ImportResult m_result;
+    qint64 m_sampledBytes = -1;
+    qint64 m_sampledRows = -1;
+    bool m_finished = false;
+};
@@ -1,12 +1,171 @@
 ﻿#include "ImportService.h"
 #include "AppLogger.h"
+#include "HeaderMatcher.h"
+#include "Inflate.h"
+#include "XlsReader.h"
+#include "XlsxReader.h"
+#include "ZipArchive.h"
+
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+// Sheets (or files) whose headers differ are laid out over the union of all headers, in order of first
+// appearance; a name repeated within a sheet keeps its repeats apart. The first sheet's
+// columns keep their positions, so its numeric columns stay valid.
+ImportResult mergeResults(const QList<ImportResult> &sheets)
+{
+    ImportResult merged = sheets.first();
+    for (qsizetype s = 1; s < sheets.size(); ++s) {
+        const ImportResult &sheet = sheets[s];
+        merged.headerConfidence = std::min(merged.headerConfidence, sheet.headerConfidence);
+        if (sheet.headers == merged.headers) {
+            merged.rows.append(sheet.rows);
+            continue;
+        }
+
+        QList<int> mapping;
+        mapping.reserve(sheet.headers.size());
+        for (qsizetype i = 0; i < sheet.headers.size(); ++i) {
+            const QString &header = sheet.headers[i];
+            const qsizetype repeat = std::count(sheet.headers.cbegin(), sheet.headers.cbegin() + i, header);
+            qsizetype target = -1;
+            for (qsizetype seen = 0, j = 0; j < merged.headers.size(); ++j) {
+                if (merged.headers[j] == header && seen++ == repeat) {
+                    target = j;
+                    break;
+                }
+            }
+            if (target < 0) {
+                target = merged.headers.size();
+                merged.headers.append(header);
+            }
+            mapping.append(int(target));
+        }
+
+        merged.rows.reserve(merged.rows.size() + sheet.rows.size());
+        for (const QStringList &row : sheet.rows) {
+            QStringList out(merged.headers.size());
+            for (qsizetype i = 0; i < row.size() && i < mapping.size(); ++i) {
+                out[mapping[i]] = row[i];
+            }
+            merged.rows.append(out);
+        }
+    }
+
+    // Rows from before a header was added are padded to the final width.
+    for (QStringList &row : merged.rows) {
+        while (row.size() < merged.headers.size()) {
+            row.append(QString());
+        }
+    }
+    return merged;
+}
+
+// The CSVs of a bundle in name order, leaving out macOS resource forks.
+QStringList csvEntries(const ZipArchive &zip)
+{
+    QStringList names;
+    const QStringList entryNames = zip.entryNames();
+    for (const QString &name : entryNames) {
+        if ((name.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)
+             || name.endsWith(QStringLiteral(".csv.gz"), Qt::CaseInsensitive))
+            && !name.startsWith(QStringLiteral("__MACOSX/"))) {
+            names.append(name);
+        }
+    }
+    names.sort();
+    return names;
+}
+
+bool isZipBundle(const QString &filePath)
+{
+    return filePath.endsWith(QStringLiteral(".zip"), Qt::CaseInsensitive);
+}
+
+ImportResult canceledResult(const QString &filePath)
+{
+    AppLogger::info(QStringLiteral("Import canceled: file=%1").arg(filePath));
+    ImportResult result;
+    result.error = QStringLiteral("Import canceled.");
+    return result;
+}
+
+// Matches names loosely (whitespace and case ignored, either containing the other). Fails when
+// not a single column matches, since the rows would only add blank lines.
+bool mapOntoHeaders(ImportResult *result, const QStringList &targetHeaders)
+{
+    const auto normalize = [](const QString &text) {
+        return QString(text).remove(' ').remove('\t').remove('\r').remove('\n').trimmed().toLower();
+    };
+    QList<int> mapping;
+    mapping.reserve(targetHeaders.size());
+    int mappedCount = 0;
+    for (const QString &target : targetHeaders) {
+        const QString targetNorm = normalize(target);
+        int srcIndex = -1;
+        for (int i = 0; i < result->headers.size(); ++i) {
+            const QString srcNorm = normalize(result->headers[i]);
+            if (!targetNorm.isEmpty() && (srcNorm == targetNorm || srcNorm.contains(targetNorm) || targetNorm.contains(srcNorm))) {
+                srcIndex = i;
+                break;
+            }
+        }
+        if (srcIndex >= 0) {
+            mappedCount += 1;
+        }
+        mapping.append(srcIndex);
+    }
+
+    if (mappedCount == 0) {
+        return false;
+    }
+
+    QList<QStringList> mappedRows;
+    mappedRows.reserve(result->rows.size());
+    for (const QStringList &row : std::as_const(result->rows)) {
+        QStringList out;
+        out.reserve(targetHeaders.size());
+        for (int i = 0; i < targetHeaders.size(); ++i) {
+            const int srcIndex = mapping[i];
+            out.append(srcIndex >= 0 && srcIndex < row.size() ? row[srcIndex] : QString());
+        }
+        mappedRows.append(out);
+    }
+    result->headers = targetHeaders;
+    result->rows = mappedRows;
+    result->numericColumns.clear();
+    return true;
+}
+
+// The file is fingerprinted again after the parse; a file rewritten meanwhile may have been
+// parsed half old and half new, so that result is not kept under either fingerprint.
+void storeInCache(const ImportCache *cache, const QString &filePath, const ImportCache::Fingerprint &source,
+                  ImportCache::Parser parser, const QString &projectName, const ImportResult &result)
+{
+    if (!source.isValid()) {
+        return;
+    }
+    if (!ImportCache::fingerprint(filePath).sameContent(source)) {
+        AppLogger::info(QStringLiteral("Import cache skipped, file changed during import: %1").arg(filePath));
+        return;
+    }
+    cache->store(source, parser, projectName, result);
+}
+}
 
 ImportService::ImportService(QObject *parent)
     : QObject(parent)
 {
 }
 
-ImportResult ImportService::importLichuangSpreadsheet(const QString &filePath, const QString &projectName) const
+ImportResult ImportService::importLichuangSpreadsheet(const QString &filePath, const QString &projectName,
+                                                      CsvResumeState *resume, ImportMonitor *monitor) const
 {
     AppLogger::info(QStringLiteral("Import request: file=%1, project=%2").arg(filePath, projectName));
     ImportResult result;
@@ -16,28 +175,85 @@ ImportResult ImportService::importLichuangSpreadsheet(const QString &filePath, c
         return result;
     }
 
-    QString csvPath;
-    QString error;
-    if (!m_converter.toCsv(filePath, &csvPath, &error)) {
-        result.error = QStringLiteral("%1\nSee import log: %2").arg(error, AppLogger::logFilePath());
-        AppLogger::error(QStringLiteral("convertSpreadsheetToCsv failed: %1").arg(error));
-        return result;
+    // A linked import needs the parser's resume state, which the cache does not keep.
+    ImportCache::Fingerprint source;
+    if (m_cache && !resume) {
+        source = ImportCache::fingerprint(filePath);
+        if (m_cache->lookup(source, ImportCache::Parser::Lichuang, projectName, &result)) {
+            AppLogger::info(QStringLiteral("Import cache hit: file=%1 rows=%2").arg(filePath).arg(result.rows.size()));
+            return result;
+        }
     }
 
-    result = m_lichuangParser.parseFile(csvPath, projectName);
+    const auto parseSheet = [this](const QList<QStringList> &table, const QString &project) {
+        return m_lichuangParser.parseTable(table, project);
+    };
+    const auto parseData = [this](QByteArrayView data, const QString &project) {
+        return m_lichuangParser.parseData(data, project);
+    };
+    // A workbook or archive is rewritten as a whole, so only a CSV source can be continued.
+    if (isZipBundle(filePath)) {
+        importArchive(filePath, projectName, parseData, &result, monitor);
+        if (resume) {
+            resume->resumable = false;
+        }
+    } else if (importWorkbook(filePath, projectName, parseSheet, &result, monitor)) {
+        if (resume) {
+            resume->resumable = false;
+        }
+    } else {
+        QString csvPath;
+        QString error;
+        if (!m_converter.toCsv(filePath, &csvPath, &error, monitor)) {
+            if (monitor && monitor->isCanceled()) {
+                return canceledResult(filePath);
+            }
+            result.error = QStringLiteral("%1\nSee import log: %2").arg(error, AppLogger::logFilePath());
+            AppLogger::error(QStringLiteral("convertSpreadsheetToCsv failed: %1").arg(error));
+            return result;
+        }
+
+        const bool csvSource = csvPath == filePath;
+        if (resume && !csvSource) {
+            resume->resumable = false;
+        }
+        result = m_lichuangParser.parseFile(csvPath, projectName, csvSource ? resume : nullptr, monitor);
+    }
+    if (monitor && monitor->isCanceled()) {
+        return canceledResult(filePath);
+    }
     if (!result.ok) {
         AppLogger::error(QStringLiteral("parseLichuangCsv failed: %1").arg(result.error));
         result.error = QStringLiteral("%1\nSee import log: %2").arg(result.error, AppLogger::logFilePath());
     } else {
-        AppLogger::info(QStringLiteral("Import success: file=%1 rows=%2 project=%3")
+        AppLogger::info(QStringLiteral("Import success: file=%1 rows=%2 project=%3 headerConfidence=%4")
                             .arg(filePath)
                             .arg(result.rows.size())
-                            .arg(projectName));
+                            .arg(projectName)
+                            .arg(result.headerConfidence, 0, 'f', 2));
+        if (m_cache) {
+            storeInCache(m_cache, filePath, source, ImportCache::Parser::Lichuang, projectName, result);
+        }
     }
     return result;
 }
 
-ImportResult ImportService::importGenericSpreadsheet(const QString &filePath, const QString &projectName) const
+bool ImportService::importAppendedLichuangRows(const QString &filePath, const QString &projectName,
+                                               CsvResumeState *resume, ImportResult *result) const
+{
+    if (!m_lichuangParser.parseAppended(filePath, projectName, resume, result)) {
+        AppLogger::info(QStringLiteral("Linked file changed before the parsed offset, full re-import: %1").arg(filePath));
+        return false;
+    }
+    AppLogger::info(QStringLiteral("Linked file tail parsed: file=%1 rows=%2 offset=%3")
+                        .arg(filePath)
+                        .arg(result->rows.size())
+                        .arg(resume->offset));
+    return true;
+}
+
+ImportResult ImportService::importGenericSpreadsheet(const QString &filePath, const QString &projectName,
+                                                     ImportMonitor *monitor) const
 {
     AppLogger::info(QStringLiteral("Generic import request: file=%1, project=%2").arg(filePath, projectName));
     ImportResult result;
@@ -47,15 +263,39 @@ ImportResult ImportService::importGenericSpreadsheet(const QString &filePath, co
         return result;
     }
 
-    QString csvPath;
-    QString error;
-    if (!m_converter.toCsv(filePath, &csvPath, &error)) {
-        result.error = QStringLiteral("%1\nSee import log: %2").arg(error, AppLogger::logFilePath());
-        AppLogger::error(QStringLiteral("convertSpreadsheetToCsv failed: %1").arg(error));
-        return result;
+    ImportCache::Fingerprint source;
+    if (m_cache) {
+        source = ImportCache::fingerprint(filePath);
+        if (m_cache->lookup(source, ImportCache::Parser::Generic, projectName, &result)) {
+            AppLogger::info(QStringLiteral("Generic import cache hit: file=%1 rows=%2").arg(filePath).arg(result.rows.size()));
+            return result;
+        }
     }
 
-    result = m_genericParser.parseFile(csvPath, projectName);
+    const auto parseSheet = [this](const QList<QStringList> &table, const QString &project) {
+        return m_genericParser.parseTable(table, project);
+    };
+    const auto parseData = [this](QByteArrayView data, const QString &project) {
+        return m_genericParser.parseData(data, project);
+    };
+    if (isZipBundle(filePath)) {
+        importArchive(filePath, projectName, parseData, &result, monitor);
+    } else if (!importWorkbook(filePath, projectName, parseSheet, &result, monitor)) {
+        QString csvPath;
+        QString error;
+        if (!m_converter.toCsv(filePath, &csvPath, &error, monitor)) {
+            if (monitor && monitor->isCanceled()) {
+                return canceledResult(filePath);
+            }
+            result.error = QStringLiteral("%1\nSee import log: %2").arg(error, AppLogger::logFilePath());
+            AppLogger::error(QStringLiteral("convertSpreadsheetToCsv failed: %1").arg(error));
+            return result;
+        }
+        result = m_genericParser.parseFile(csvPath, projectName, monitor);
+    }
+    if (monitor && monitor->isCanceled()) {
+        return canceledResult(filePath);
+    }
     if (!result.ok) {
         AppLogger::error(QStringLiteral("parseGenericCsv failed: %1").arg(result.error));
         result.error = QStringLiteral("%1\nSee import log: %2").arg(result.error, AppLogger::logFilePath());
@@ -64,6 +304,366 @@ ImportResult ImportService::importGenericSpreadsheet(const QString &filePath, co
                             .arg(filePath)
                             .arg(result.rows.size())
                             .arg(projectName));
+        if (m_cache) {
+            storeInCache(m_cache, filePath, source, ImportCache::Parser::Generic, projectName, result);
+        }
     }
     return result;
 }
+
+bool ImportService::importWorkbook(const QString &filePath, const QString &projectName, const SheetParser &parseSheet,
+                                   ImportResult *result, ImportMonitor *monitor) const
+{
+    const bool xlsx = filePath.endsWith(QStringLiteral(".xlsx"), Qt::CaseInsensitive);
+    const bool xls = filePath.endsWith(QStringLiteral(".xls"), Qt::CaseInsensitive);
+    if (!xlsx && !xls) {
+        return false;
+    }
+
+    XlsxReader xlsxReader;
+    XlsReader xlsReader;
+    QString error;
+    if (!(xlsx ? xlsxReader.open(filePath, &error) : xlsReader.open(filePath, &error))) {
+        AppLogger::warn(QStringLiteral("Native %1 read failed, trying external converters: %2")
+                            .arg(xlsx ? QStringLiteral("xlsx") : QStringLiteral("xls"), error));
+        return false;
+    }
+
+    // Both readers only read shared state once open, so sheets decode and parse side by side.
+    const QStringList sheetNames = xlsx ? xlsxReader.sheetNames() : xlsReader.sheetNames();
+    const auto importSheet = [&](int index, const QString &project, ImportResult *sheetResult, QString *sheetError) {
+        QList<QStringList> table;
+        if (!(xlsx ? xlsxReader.readSheet(index, &table, sheetError) : xlsReader.readSheet(index, &table, sheetError))) {
+            return false;
+        }
+        if (!table.isEmpty()) {
+            *sheetResult = parseSheet(table, project);
+        }
+        return true;
+    };
+    if (!importParts(filePath, projectName, sheetNames, importSheet, result, monitor)) {
+        AppLogger::warn(QStringLiteral("Native workbook read failed, trying external converters: %1").arg(result->error));
+        *result = ImportResult();
+        return false;
+    }
+    return true;
+}
+
+void ImportService::importArchive(const QString &filePath, const QString &projectName, const DataParser &parseData,
+                                  ImportResult *result, ImportMonitor *monitor) const
+{
+    ZipArchive zip;
+    QString error;
+    if (!zip.open(filePath, &error)) {
+        result->error = error;
+        return;
+    }
+
+    const QStringList csvNames = csvEntries(zip);
+    if (csvNames.isEmpty()) {
+        result->error = QStringLiteral("No CSV file found in archive: %1").arg(filePath);
+        return;
+    }
+
+    // Entries are inflated into memory one per task; nothing is extracted to disk.
+    const auto importEntry = [&](int index, const QString &project, ImportResult *entryResult, QString *entryError) {
+        QByteArray data;
+        if (!zip.read(csvNames[index], &data, entryError)) {
+            return false;
+        }
+        if (Inflate::isGzip(data)) {
+            QByteArray inflated;
+            if (!Inflate::gunzip(data, &inflated)) {
+                *entryError = QStringLiteral("Corrupt or unsupported gzip entry: %1").arg(csvNames[index]);
+                return false;
+            }
+            data = inflated;
+        }
+        if (!data.isEmpty()) {
+            *entryResult = parseData(data, project);
+        }
+        return true;
+    };
+    QStringList projects;
+    for (const QString &name : std::as_const(csvNames)) {
+        QString fileName = QFileInfo(name).fileName();
+        if (fileName.endsWith(QStringLiteral(".gz"), Qt::CaseInsensitive)) {
+            fileName.chop(3);
+        }
+        projects.append(QFileInfo(fileName).completeBaseName());
+    }
+    importParts(filePath, projectName, projects, importEntry, result, monitor);
+}
+
+bool ImportService::importParts(const QString &filePath, const QString &projectName, const QStringList &partNames,
+                                const PartImporter &importPart, ImportResult *result, ImportMonitor *monitor) const
+{
+    QList<ImportPart> parts(partNames.size());
+    for (qsizetype i = 0; i < parts.size(); ++i) {
+        parts[i].index = int(i);
+        parts[i].name = partNames[i].trimmed();
+    }
+
+    // Progress counts finished parts against the file size.
+    const qint64 size = QFileInfo(filePath).size();
+    if (monitor) {
+        monitor->setTotalBytes(size);
+    }
+    QAtomicInteger<qint64> partsDone;
+    QAtomicInteger<qint64> rowsParsed;
+    const bool single = parts.size() == 1;
+    QtConcurrent::blockingMap(parts, [&](ImportPart &part) {
+        if (monitor && monitor->isCanceled()) {
+            return;
+        }
+        const QString project = (single || part.name.isEmpty()) ? projectName : part.name;
+        part.read = importPart(part.index, project, &part.result, &part.error);
+        if (monitor) {
+            monitor->setBytesRead(size * (partsDone.fetchAndAddRelaxed(1) + 1) / parts.size());
+            monitor->setRowsParsed(rowsParsed.fetchAndAddRelaxed(part.result.rows.size()) + part.result.rows.size());
+        }
+    });
+    // The caller reports the cancel; no fallback may be tried instead.
+    if (monitor && monitor->isCanceled()) {
+        return true;
+    }
+
+    const auto unread = std::find_if(parts.cbegin(), parts.cend(), [](const ImportPart &part) { return !part.read; });
+    if (std::none_of(parts.cbegin(), parts.cend(), [](const ImportPart &part) { return part.read; })) {
+        result->error = unread == parts.cend() ? QString() : unread->error;
+        return false;
+    }
+
+    // Parts without BOM rows (notes, cover pages) are skipped as long as one part has some.
+    QList<ImportResult> parsed;
+    QStringList projects;
+    ImportResult firstFailure;
+    for (const ImportPart &part : std::as_const(parts)) {
+        if (part.result.ok) {
+            parsed.append(part.result);
+            const QString project = (single || part.name.isEmpty()) ? projectName : part.name;
+            if (!projects.contains(project)) {
+                projects.append(project);
+            }
+            continue;
+        }
+        const QString reason = part.read ? part.result.error : part.error;
+        if (!reason.isEmpty()) {
+            AppLogger::info(QStringLiteral("Part skipped: file=%1 part=%2 reason=%3").arg(filePath, part.name, reason));
+            if (firstFailure.error.isEmpty()) {
+                firstFailure.error = reason;
+            }
+        }
+    }
+    if (parsed.isEmpty()) {
+        *result = firstFailure;
+        if (result->error.isEmpty()) {
+            result->error = QStringLiteral("No sheet or file inside %1 contains data.").arg(QFileInfo(filePath).fileName());
+        }
+        return true;
+    }
+    *result = mergeResults(parsed);
+    if (!single) {
+        result->projects = projects;
+    }
+    AppLogger::info(QStringLiteral("Read in-process: file=%1 parts=%2 imported=%3")
+                        .arg(filePath)
+                        .arg(parts.size())
+                        .arg(parsed.size()));
+    return true;
+}
+
+ImportPreview ImportService::previewImport(const QString &filePath, bool lichuang, const QString &projectName,
+                                           const QStringList &targetHeaders, int maxRows) const
+{
+    ImportPreview preview;
+    QList<QStringList> table;
+    QString error;
+    if (!readPreviewTable(filePath, maxRows, &table, &error)) {
+        preview.sample.error = error;
+        return preview;
+    }
+
+    if (lichuang) {
+        preview.sample = m_lichuangParser.parseTable(table, projectName, &preview.sourceHeaders);
+    } else {
+        preview.sample = m_genericParser.parseTable(table, projectName);
+        // The generic parser keeps the first non-blank row as headers and adds a project column
+        // in front when none of them names one.
+        const auto header = std::find_if(table.cbegin(), table.cend(), [](const QStringList &row) {
+            return std::any_of(row.cbegin(), row.cend(), [](const QString &cell) { return !cell.trimmed().isEmpty(); });
+        });
+        if (header != table.cend()) {
+            preview.sourceHeaders = *header;
+            if (HeaderMatcher::projectColumn().findColumn(*header, 0) < 0) {
+                preview.sourceHeaders.prepend(QString());
+            }
+        }
+        preview.sourceHeaders.resize(preview.sample.headers.size());
+    }
+    if (!preview.sample.ok) {
+        return preview;
+    }
+
+    ImportResult mapped = preview.sample;
+    preview.fitsView = targetHeaders.isEmpty() || preview.sample.headers == targetHeaders
+        || (lichuang && mapOntoHeaders(&mapped, targetHeaders));
+    return preview;
+}
+
+bool ImportService::readPreviewTable(const QString &filePath, int maxRows, QList<QStringList> *table,
+                                     QString *error) const
+{
+    const QString unsupported = QStringLiteral("No preview for this file; it needs an external converter.");
+    if (filePath.endsWith(QStringLiteral(".xlsx"), Qt::CaseInsensitive)) {
+        XlsxReader reader;
+        if (!reader.open(filePath, error)) {
+            *error = unsupported;
+            return false;
+        }
+        return reader.readSheet(0, table, error, maxRows);
+    }
+    if (filePath.endsWith(QStringLiteral(".xls"), Qt::CaseInsensitive)) {
+        XlsReader reader;
+        if (!reader.open(filePath, error)) {
+            *error = unsupported;
+            return false;
+        }
+        return reader.readSheet(0, table, error, maxRows);
+    }
+    if (isZipBundle(filePath)) {
+        // The first CSV of a bundle stands for all of them.
+        ZipArchive zip;
+        if (!zip.open(filePath, error)) {
+            return false;
+        }
+        const QStringList names = csvEntries(zip);
+        if (names.isEmpty()) {
+            *error = QStringLiteral("No CSV file found in archive: %1").arg(filePath);
+            return false;
+        }
+        QByteArray data;
+        bool complete = true;
+        if (names.first().endsWith(QStringLiteral(".gz"), Qt::CaseInsensitive)) {
+            // A gzip member needs its trailer, so the compressed entry is read whole.
+            QByteArray compressed;
+            if (!zip.read(names.first(), &compressed, error)) {
+                return false;
+            }
+            if (!Inflate::gunzip(compressed, &data, CsvPreview::PreviewBytes)) {
+                *error = QStringLiteral("Corrupt or unsupported gzip entry: %1").arg(names.first());
+                return false;
+            }
+            complete = data.size() < CsvPreview::PreviewBytes;
+        } else if (!zip.readPrefix(names.first(), CsvPreview::PreviewBytes, &data, &complete, error)) {
+            return false;
+        }
+        CsvPreview::readData(data, maxRows, table, !complete);
+        return true;
+    }
+    return CsvPreview::readFile(filePath, maxRows, table, error);
+}
+
+ImportJob *ImportService::startLichuangImport(const QString &filePath, const QString &projectName,
+                                              const QStringList &targetHeaders, QObject *parent) const
+{
+    return new ImportJob([this, filePath, projectName, targetHeaders](ImportMonitor *monitor) {
+        ImportResult result = importLichuangSpreadsheet(filePath, projectName, nullptr, monitor);
+        if (result.ok && !targetHeaders.isEmpty() && result.headers != targetHeaders
+            && !mapOntoHeaders(&result, targetHeaders)) {
+            result = ImportResult();
+            result.error = QStringLiteral("header mismatch with current BOM view. Import aborted to avoid overwriting existing data.");
+        }
+        return result;
+    }, parent);
+}
+
+ImportJob *ImportService::startGenericImport(const QString &filePath, const QString &projectName, QObject *parent) const
+{
+    return new ImportJob([this, filePath, projectName](ImportMonitor *monitor) {
+        return importGenericSpreadsheet(filePath, projectName, monitor);
+    }, parent);
+}
+
+ImportJob *ImportService::startLinkedImport(const QString &filePath, const QString &projectName,
+                                            std::shared_ptr<LinkState> state, QObject *parent) const
+{
+    return new ImportJob([this, filePath, projectName, state = std::move(state)](ImportMonitor *monitor) {
+        ImportResult result;
+        state->appendedOnly = state->resume.resumable
+            && importAppendedLichuangRows(filePath, projectName, &state->resume, &result);
+        if (state->appendedOnly) {
+            return result;
+        }
+        return importLichuangSpreadsheet(filePath, projectName, &state->resume, monitor);
+    }, parent);
+}
+
+ImportJob *ImportService::startBatchImport(const QList<BatchFile> &files, bool lichuang,
+                                           const QStringList &targetHeaders, QObject *parent) const
+{
+    return new ImportJob([this, files, lichuang, targetHeaders](ImportMonitor *monitor) {
+        struct Entry {
+            BatchFile file;
+            qint64 size = 0;
+            ImportResult result;
+        };
+        QList<Entry> entries;
+        entries.reserve(files.size());
+        qint64 totalBytes = 0;
+        for (const BatchFile &file : files) {
+            entries.append({file, QFileInfo(file.path).size(), ImportResult()});
+            totalBytes += entries.last().size;
+        }
+        monitor->setTotalBytes(totalBytes);
+
+        // A pool of its own keeps the files to one per core; the sheets and chunks each file
+        // splits into still go to the global pool.
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+        QAtomicInteger<qint64> bytesDone;
+        QAtomicInteger<qint64> rowsDone;
+        QtConcurrent::blockingMap(&pool, entries, [&](Entry &entry) {
+            if (monitor->isCanceled()) {
+                return;
+            }
+            ImportMonitor fileMonitor(monitor);
+            entry.result = lichuang ? importLichuangSpreadsheet(entry.file.path, entry.file.project, nullptr, &fileMonitor)
+                                    : importGenericSpreadsheet(entry.file.path, entry.file.project, &fileMonitor);
+            if (lichuang && entry.result.ok && !targetHeaders.isEmpty() && entry.result.headers != targetHeaders
+                && !mapOntoHeaders(&entry.result, targetHeaders)) {
+                entry.result = ImportResult();
+                entry.result.error = QStringLiteral("header mismatch with current BOM view.");
+            }
+            monitor->setBytesRead(bytesDone.fetchAndAddRelaxed(entry.size) + entry.size);
+            monitor->setRowsParsed(rowsDone.fetchAndAddRelaxed(entry.result.rows.size()) + entry.result.rows.size());
+        });
+        if (monitor->isCanceled()) {
+            return canceledResult(QStringLiteral("%1 files").arg(files.size()));
+        }
+
+        QList<ImportResult> imported;
+        QStringList failures;
+        for (const Entry &entry : std::as_const(entries)) {
+            if (entry.result.ok) {
+                imported.append(entry.result);
+            } else {
+                failures.append(QStringLiteral("%1: %2").arg(QFileInfo(entry.file.path).fileName(),
+                                                             entry.result.error.section('\n', 0, 0)));
+            }
+        }
+        AppLogger::info(QStringLiteral("Batch import: files=%1 imported=%2 failed=%3")
+                            .arg(files.size())
+                            .arg(imported.size())
+                            .arg(failures.size()));
+
+        ImportResult result;
+        if (imported.isEmpty()) {
+            result.error = QStringLiteral("no file could be imported (%1).").arg(failures.join(QStringLiteral("; ")));
+        } else {
+            result = mergeResults(imported);
+        }
+        result.failures = failures;
+        return result;
+    }, parent);
+}
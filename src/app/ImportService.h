@@ -2,8 +2,14 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <memory>
 
 #include "ImportTypes.h"
+#include "ImportCache.h"
+#include "ImportJob.h"
 #include "SpreadsheetConverter.h"
 #include "CsvParsers.h"
 
@@ -13,10 +19,89 @@ class ImportService : public QObject
 public:
     explicit ImportService(QObject *parent = nullptr);
 
-    ImportResult importLichuangSpreadsheet(const QString &filePath, const QString &projectName) const;
-    ImportResult importGenericSpreadsheet(const QString &filePath, const QString &projectName) const;
+    // Repeat imports of an unchanged file are served from cache when one is set.
+    void setCache(const ImportCache *cache) { m_cache = cache; }
+
+    // resume is filled when filePath is a CSV that later imports can continue from. monitor
+    // receives progress and, once canceled, ends the import with a failed result.
+    ImportResult importLichuangSpreadsheet(const QString &filePath, const QString &projectName,
+                                           CsvResumeState *resume = nullptr, ImportMonitor *monitor = nullptr) const;
+    bool importAppendedLichuangRows(const QString &filePath, const QString &projectName, CsvResumeState *resume,
+                                    ImportResult *result) const;
+    ImportResult importGenericSpreadsheet(const QString &filePath, const QString &projectName,
+                                          ImportMonitor *monitor = nullptr) const;
+
+    // Asynchronous forms of the imports above; the service must outlive the returned job.
+    // targetHeaders are the headers the BOM view already has: rows under different headers
+    // are mapped onto them by name on the worker thread as well.
+    ImportJob *startLichuangImport(const QString &filePath, const QString &projectName,
+                                   const QStringList &targetHeaders, QObject *parent = nullptr) const;
+    ImportJob *startGenericImport(const QString &filePath, const QString &projectName, QObject *parent = nullptr) const;
+
+    // What a linked LCSC file carries from one import to the next.
+    struct LinkState {
+        CsvResumeState resume;
+        // Set by the job when only the rows appended since the last import were read.
+        bool appendedOnly = false;
+    };
+
+    // Imports a linked LCSC file: only the rows appended since the last import while state's
+    // resume point still matches the file, the whole file otherwise. The job updates state on
+    // the worker; leave it alone until the job has finished.
+    ImportJob *startLinkedImport(const QString &filePath, const QString &projectName,
+                                 std::shared_ptr<LinkState> state, QObject *parent = nullptr) const;
+
+    static constexpr int PreviewRows = 200;
+
+    // Reads and shapes only the first maxRows records, so it returns in milliseconds even for
+    // huge files. targetHeaders are the current view's headers, checked as the asynchronous
+    // imports would. Files that need an external converter cannot be previewed.
+    ImportPreview previewImport(const QString &filePath, bool lichuang, const QString &projectName,
+                                const QStringList &targetHeaders, int maxRows = PreviewRows) const;
+
+    struct BatchFile {
+        QString path;
+        QString project;
+    };
+
+    // Imports many files as one job: files are converted and parsed side by side, up to one
+    // per core (external converter processes are capped separately), and the results come
+    // back merged into one. Files that fail are listed in ImportResult::failures; the job
+    // fails only when none could be imported.
+    ImportJob *startBatchImport(const QList<BatchFile> &files, bool lichuang, const QStringList &targetHeaders,
+                                QObject *parent = nullptr) const;
 
 private:
+    using SheetParser = std::function<ImportResult(const QList<QStringList> &table, const QString &projectName)>;
+    using DataParser = std::function<ImportResult(QByteArrayView data, const QString &projectName)>;
+    // Reads part index of a file and parses it into projectName. Returns false with *error set
+    // when the part cannot be read; leaves *result untouched for a part without data.
+    using PartImporter = std::function<bool(int index, const QString &projectName, ImportResult *result, QString *error)>;
+
+    struct ImportPart {
+        int index = 0;
+        QString name;
+        bool read = false;
+        QString error;
+        ImportResult result;
+    };
+
+    // Imports every worksheet of an .xlsx or BIFF8 .xls in-process. False for other formats or
+    // when the workbook needs an external converter, which reads the first sheet only.
+    bool importWorkbook(const QString &filePath, const QString &projectName, const SheetParser &parseSheet,
+                        ImportResult *result, ImportMonitor *monitor) const;
+    // Imports every .csv (or .csv.gz) entry of a ZIP bundle, inflated in memory.
+    void importArchive(const QString &filePath, const QString &projectName, const DataParser &parseData,
+                       ImportResult *result, ImportMonitor *monitor) const;
+    // Imports the parts of a workbook or bundle as one pool task each. Each part's rows go to a
+    // project named after the part (projectName when there is only one) and all parts come
+    // back as one result. False, with the first read error, when no part could be read.
+    bool importParts(const QString &filePath, const QString &projectName, const QStringList &partNames,
+                     const PartImporter &importPart, ImportResult *result, ImportMonitor *monitor) const;
+
+    bool readPreviewTable(const QString &filePath, int maxRows, QList<QStringList> *table, QString *error) const;
+
+    const ImportCache *m_cache = nullptr;
     SpreadsheetConverter m_converter;
     LichuangCsvParser m_lichuangParser;
     GenericCsvParser m_genericParser;
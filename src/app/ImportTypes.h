@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QAtomicInteger>
 #include <QList>
 #include <QStringList>
 
@@ -8,4 +9,58 @@ struct ImportResult {
     QString error;
     QStringList headers;
     QList<QStringList> rows;
+    // Share of the known columns found in the detected header row (LCSC imports only).
+    double headerConfidence = 0.0;
+    // Columns of quantity, unit price and amount, indexed by BomTableModel::NumericField.
+    QList<int> numericColumns;
+    // Batch imports only: one "file: reason" line per file that was left out.
+    QStringList failures;
+    // Workbooks and bundles with several parts: the projects their rows went to, in part
+    // order. Empty when every row went to the project the import was started for.
+    QStringList projects;
+};
+
+// A dry run over the first records of a file: the rows an import would produce from them
+// and where each of its columns is read from.
+struct ImportPreview {
+    ImportResult sample;
+    // Per header of sample, the source header cell it comes from; empty for a column the
+    // import fills in itself (the project).
+    QStringList sourceHeaders;
+    // Whether the rows would be added to the current view without replacing its headers.
+    bool fitsView = false;
+};
+
+// Shared between an import running on a worker thread and whoever started it: the import
+// publishes how far it got and polls isCanceled() at its natural checkpoints; either side may
+// touch it at any time. A monitor with a parent also counts as canceled once the parent is,
+// which lets each file of a batch keep its own counters.
+class ImportMonitor
+{
+public:
+    explicit ImportMonitor(const ImportMonitor *parent = nullptr)
+        : m_parent(parent)
+    {
+    }
+
+    void cancel() { m_canceled.storeRelaxed(1); }
+    bool isCanceled() const { return m_canceled.loadRelaxed() != 0 || (m_parent && m_parent->isCanceled()); }
+
+    void setTotalBytes(qint64 bytes) { m_totalBytes.storeRelaxed(bytes); }
+    void setBytesRead(qint64 bytes) { m_bytesRead.storeRelaxed(bytes); }
+    void setRowsParsed(qint64 rows) { m_rowsParsed.storeRelaxed(rows); }
+    // For producers that report from several threads at once.
+    void addBytesRead(qint64 bytes) { m_bytesRead.fetchAndAddRelaxed(bytes); }
+    void addRowsParsed(qint64 rows) { m_rowsParsed.fetchAndAddRelaxed(rows); }
+
+    qint64 totalBytes() const { return m_totalBytes.loadRelaxed(); }
+    qint64 bytesRead() const { return m_bytesRead.loadRelaxed(); }
+    qint64 rowsParsed() const { return m_rowsParsed.loadRelaxed(); }
+
+private:
+    const ImportMonitor *m_parent = nullptr;
+    QAtomicInt m_canceled;
+    QAtomicInteger<qint64> m_totalBytes;
+    QAtomicInteger<qint64> m_bytesRead;
+    QAtomicInteger<qint64> m_rowsParsed;
 };
@@ -0,0 +1,485 @@
+#include "Inflate.h"
+
+#include <cstring>
+
+namespace Inflate {
+namespace {
+constexpr int MaxBits = 15;
+constexpr int FastBits = 10;
+constexpr int MaxLiteralCodes = 288;
+constexpr int MaxDistanceCodes = 30;
+
+constexpr quint16 LengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr quint8 LengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr quint16 DistanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                      193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                      6145, 8193, 12289, 16385, 24577};
+constexpr quint8 DistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                      6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr quint8 CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// LSB-first bit buffer over the input. Reads past the end yield zero bytes and are counted,
+// so the hot path needs no bounds checks; overrun() reports whether any of them were consumed.
+class BitReader
+{
+public:
+    explicit BitReader(QByteArrayView input)
+        : m_next(reinterpret_cast<const uchar *>(input.data()))
+        , m_end(m_next + input.size())
+    {
+    }
+
+    void refill()
+    {
+        while (m_count <= 56) {
+            quint64 byte = 0;
+            if (m_next < m_end) {
+                byte = *m_next++;
+            } else {
+                ++m_padding;
+            }
+            m_bits |= byte << m_count;
+            m_count += 8;
+        }
+    }
+
+    quint32 peek(int bits) const { return quint32(m_bits & ((quint64(1) << bits) - 1)); }
+
+    void consume(int bits)
+    {
+        m_bits >>= bits;
+        m_count -= bits;
+    }
+
+    quint32 take(int bits)
+    {
+        if (m_count < bits) {
+            refill();
+        }
+        const quint32 value = peek(bits);
+        consume(bits);
+        return value;
+    }
+
+    bool overrun() const { return m_padding * 8 > m_count; }
+
+    // Whole input bytes not consumed yet; a partly consumed byte counts as consumed.
+    qsizetype remaining() const { return (m_end - m_next) + m_count / 8 - m_padding; }
+
+    void alignToByte() { consume(m_count % 8); }
+
+    // Copies whole bytes after alignToByte(), first from the bit buffer, then from the input.
+    bool readBytes(uchar *out, qsizetype size)
+    {
+        const qsizetype buffered = m_count / 8 - m_padding;
+        if (buffered < 0 || size > buffered + (m_end - m_next)) {
+            return false;
+        }
+        while (size > 0 && m_count >= 8) {
+            *out++ = uchar(m_bits);
+            consume(8);
+            --size;
+        }
+        std::memcpy(out, m_next, size_t(size));
+        m_next += size;
+        return true;
+    }
+
+private:
+    const uchar *m_next = nullptr;
+    const uchar *m_end = nullptr;
+    quint64 m_bits = 0;
+    int m_count = 0;
+    qsizetype m_padding = 0;
+};
+
+// Canonical Huffman code. Codes up to FastBits long resolve with one table lookup; longer
+// ones fall back to walking the code lengths a bit at a time.
+class Huffman
+{
+public:
+    bool build(const quint8 *lengths, int count)
+    {
+        std::memset(m_counts, 0, sizeof(m_counts));
+        std::memset(m_fast, 0, sizeof(m_fast));
+        for (int i = 0; i < count; ++i) {
+            ++m_counts[lengths[i]];
+        }
+        m_counts[0] = 0;
+
+        // An over-subscribed code cannot be decoded; an incomplete one is allowed and only
+        // fails if the stream actually uses a missing code.
+        int left = 1;
+        for (int len = 1; len <= MaxBits; ++len) {
+            left <<= 1;
+            left -= m_counts[len];
+            if (left < 0) {
+                return false;
+            }
+        }
+
+        quint16 offsets[MaxBits + 2];
+        quint32 nextCode[MaxBits + 1];
+        offsets[1] = 0;
+        quint32 code = 0;
+        for (int len = 1; len <= MaxBits; ++len) {
+            offsets[len + 1] = quint16(offsets[len] + m_counts[len]);
+            code = (code + (len > 1 ? m_counts[len - 1] : 0)) << 1;
+            nextCode[len] = code;
+        }
+
+        for (int symbol = 0; symbol < count; ++symbol) {
+            const int len = lengths[symbol];
+            if (len == 0) {
+                continue;
+            }
+            m_symbols[offsets[len]++] = quint16(symbol);
+            const quint32 assigned = nextCode[len]++;
+            if (len <= FastBits) {
+                quint32 reversed = 0;
+                for (int bit = 0; bit < len; ++bit) {
+                    reversed |= ((assigned >> bit) & 1u) << (len - 1 - bit);
+                }
+                const quint16 entry = quint16((symbol << 4) | len);
+                for (quint32 fill = reversed; fill < (1u << FastBits); fill += 1u << len) {
+                    m_fast[fill] = entry;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Returns the next symbol, or -1 for a code the table does not contain.
+    int decode(BitReader &in) const
+    {
+        in.refill();
+        const quint16 entry = m_fast[in.peek(FastBits)];
+        if (entry != 0) {
+            in.consume(entry & 15);
+            return entry >> 4;
+        }
+
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len <= MaxBits; ++len) {
+            code |= int(in.take(1));
+            const int count = m_counts[len];
+            if (code - count < first) {
+                return m_symbols[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+private:
+    quint16 m_counts[MaxBits + 1] = {};
+    quint16 m_symbols[MaxLiteralCodes] = {};
+    quint16 m_fast[1 << FastBits] = {};
+};
+
+class Decoder
+{
+public:
+    // With stopWhenFull, decoding ends successfully once the output is full instead of
+    // failing on a stream that would write past it.
+    Decoder(QByteArrayView input, uchar *output, qsizetype outputSize, bool stopWhenFull = false)
+        : m_in(input)
+        , m_out(output)
+        , m_outEnd(output + outputSize)
+        , m_outStart(output)
+        , m_stopWhenFull(stopWhenFull)
+    {
+    }
+
+    qsizetype remaining() const { return m_in.remaining(); }
+
+    bool run()
+    {
+        bool last = false;
+        while (!last) {
+            last = m_in.take(1) != 0;
+            bool ok = false;
+            switch (m_in.take(2)) {
+            case 0:
+                ok = stored();
+                break;
+            case 1:
+                ok = fixed();
+                break;
+            case 2:
+                ok = dynamic();
+                break;
+            default:
+                break;
+            }
+            if (!ok || m_in.overrun()) {
+                return false;
+            }
+            if (m_full) {
+                return true;
+            }
+        }
+        return m_out == m_outEnd;
+    }
+
+private:
+    bool stored()
+    {
+        m_in.alignToByte();
+        const quint32 length = m_in.take(16);
+        if ((m_in.take(16) ^ 0xFFFFu) != length) {
+            return false;
+        }
+        qsizetype count = length;
+        if (count > m_outEnd - m_out) {
+            if (!m_stopWhenFull) {
+                return false;
+            }
+            count = m_outEnd - m_out;
+            m_full = true;
+        }
+        if (!m_in.readBytes(m_out, count)) {
+            return false;
+        }
+        m_out += count;
+        return true;
+    }
+
+    bool fixed()
+    {
+        static const struct FixedCodes {
+            Huffman literals;
+            Huffman distances;
+            FixedCodes()
+            {
+                quint8 lengths[MaxLiteralCodes];
+                std::memset(lengths, 8, 144);
+                std::memset(lengths + 144, 9, 112);
+                std::memset(lengths + 256, 7, 24);
+                std::memset(lengths + 280, 8, 8);
+                literals.build(lengths, MaxLiteralCodes);
+                std::memset(lengths, 5, MaxDistanceCodes);
+                distances.build(lengths, MaxDistanceCodes);
+            }
+        } codes;
+        return decodeBlock(codes.literals, codes.distances);
+    }
+
+    bool dynamic()
+    {
+        const int literalCount = int(m_in.take(5)) + 257;
+        const int distanceCount = int(m_in.take(5)) + 1;
+        const int codeLengthCount = int(m_in.take(4)) + 4;
+        if (literalCount > 286 || distanceCount > MaxDistanceCodes) {
+            return false;
+        }
+
+        quint8 lengths[MaxLiteralCodes + MaxDistanceCodes] = {};
+        for (int i = 0; i < codeLengthCount; ++i) {
+            lengths[CodeLengthOrder[i]] = quint8(m_in.take(3));
+        }
+        Huffman codeLengths;
+        if (!codeLengths.build(lengths, 19)) {
+            return false;
+        }
+
+        const int total = literalCount + distanceCount;
+        int index = 0;
+        while (index < total) {
+            const int symbol = codeLengths.decode(m_in);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[index++] = quint8(symbol);
+                continue;
+            }
+
+            quint8 value = 0;
+            int repeat = 0;
+            if (symbol == 16) {
+                if (index == 0) {
+                    return false;
+                }
+                value = lengths[index - 1];
+                repeat = 3 + int(m_in.take(2));
+            } else if (symbol == 17) {
+                repeat = 3 + int(m_in.take(3));
+            } else {
+                repeat = 11 + int(m_in.take(7));
+            }
+            if (index + repeat > total) {
+                return false;
+            }
+            std::memset(lengths + index, value, size_t(repeat));
+            index += repeat;
+        }
+
+        // Without an end-of-block code the block could never terminate.
+        if (lengths[256] == 0) {
+            return false;
+        }
+
+        Huffman literals;
+        Huffman distances;
+        return literals.build(lengths, literalCount) && distances.build(lengths + literalCount, distanceCount)
+            && decodeBlock(literals, distances);
+    }
+
+    bool decodeBlock(const Huffman &literals, const Huffman &distances)
+    {
+        for (;;) {
+            const int symbol = literals.decode(m_in);
+            if (symbol < 256) {
+                if (symbol >= 0 && m_out == m_outEnd && m_stopWhenFull) {
+                    m_full = true;
+                    return true;
+                }
+                if (symbol < 0 || m_out == m_outEnd) {
+                    return false;
+                }
+                *m_out++ = uchar(symbol);
+                continue;
+            }
+            if (symbol == 256) {
+                return true;
+            }
+
+            const int lengthCode = symbol - 257;
+            if (lengthCode >= 29) {
+                return false;
+            }
+            const qsizetype fullLength = LengthBase[lengthCode] + qsizetype(m_in.take(LengthExtra[lengthCode]));
+
+            const int distanceCode = distances.decode(m_in);
+            if (distanceCode < 0 || distanceCode >= MaxDistanceCodes) {
+                return false;
+            }
+            const qsizetype distance = DistanceBase[distanceCode] + qsizetype(m_in.take(DistanceExtra[distanceCode]));
+            qsizetype length = fullLength;
+            if (length > m_outEnd - m_out && m_stopWhenFull) {
+                length = m_outEnd - m_out;
+                m_full = true;
+            }
+            if (distance > m_out - m_outStart || length > m_outEnd - m_out) {
+                return false;
+            }
+
+            const uchar *from = m_out - distance;
+            if (distance >= length) {
+                std::memcpy(m_out, from, size_t(length));
+                m_out += length;
+            } else {
+                // Overlapping copy repeats the last distance bytes, so it must go byte by byte.
+                for (qsizetype i = 0; i < length; ++i) {
+                    *m_out++ = *from++;
+                }
+            }
+            if (m_in.overrun()) {
+                return false;
+            }
+            if (m_full) {
+                return true;
+            }
+        }
+    }
+
+    BitReader m_in;
+    uchar *m_out = nullptr;
+    uchar *m_outEnd = nullptr;
+    uchar *m_outStart = nullptr;
+    bool m_stopWhenFull = false;
+    bool m_full = false;
+};
+} // namespace
+
+bool inflateRaw(QByteArrayView input, qsizetype outputSize, QByteArray *output, qsizetype *remaining)
+{
+    output->resize(outputSize);
+    Decoder decoder(input, reinterpret_cast<uchar *>(output->data()), outputSize);
+    if (!decoder.run()) {
+        output->clear();
+        return false;
+    }
+    if (remaining) {
+        *remaining = decoder.remaining();
+    }
+    return true;
+}
+
+bool inflatePrefix(QByteArrayView input, qsizetype outputSize, QByteArray *output)
+{
+    output->resize(outputSize);
+    Decoder decoder(input, reinterpret_cast<uchar *>(output->data()), outputSize, true);
+    if (!decoder.run()) {
+        output->clear();
+        return false;
+    }
+    return true;
+}
+
+bool isGzip(QByteArrayView data)
+{
+    return data.size() >= 2 && uchar(data[0]) == 0x1F && uchar(data[1]) == 0x8B;
+}
+
+bool gunzip(QByteArrayView input, QByteArray *output, qsizetype maxSize)
+{
+    output->clear();
+    constexpr qsizetype HeaderSize = 10;
+    constexpr qsizetype TrailerSize = 8;
+    if (input.size() < HeaderSize + TrailerSize || !isGzip(input) || input[2] != 8) {
+        return false;
+    }
+    const auto *u = reinterpret_cast<const uchar *>(input.data());
+    const uchar flags = u[3];
+    qsizetype pos = HeaderSize;
+    if (flags & 0x04) { // FEXTRA
+        if (pos + 2 > input.size()) {
+            return false;
+        }
+        pos += 2 + (u[pos] | (u[pos + 1] << 8));
+    }
+    for (const uchar field : {uchar(0x08), uchar(0x10)}) { // FNAME, FCOMMENT
+        if (flags & field) {
+            const qsizetype end = pos < input.size() ? input.indexOf('\0', pos) : -1;
+            if (end < 0) {
+                return false;
+            }
+            pos = end + 1;
+        }
+    }
+    if (flags & 0x02) { // FHCRC
+        pos += 2;
+    }
+    if (pos + TrailerSize > input.size()) {
+        return false;
+    }
+
+    const uchar *trailer = u + input.size() - 4;
+    const quint32 size = quint32(trailer[0]) | (quint32(trailer[1]) << 8) | (quint32(trailer[2]) << 16)
+        | (quint32(trailer[3]) << 24);
+    const QByteArrayView deflated = input.sliced(pos, input.size() - pos - TrailerSize);
+    if (!withinExpansionBound(size, deflated.size())) {
+        return false;
+    }
+    if (maxSize >= 0 && maxSize < qint64(size)) {
+        return inflatePrefix(deflated, maxSize, output);
+    }
+    // Bytes left after the stream mean a second member, whose data would be silently lost.
+    qsizetype remaining = 0;
+    if (!inflateRaw(deflated, qsizetype(size), output, &remaining) || remaining != 0) {
+        output->clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace Inflate
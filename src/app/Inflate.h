@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+namespace Inflate {
+
+// DEFLATE expands its input by at most 1032:1, so a declared output size past this bound is
+// corrupt or hostile and must be refused before it is allocated.
+inline bool withinExpansionBound(qint64 outputSize, qint64 inputSize)
+{
+    return outputSize <= (inputSize + 1) * 1032;
+}
+
+// Decodes a raw DEFLATE stream (RFC 1951), as stored in ZIP entries, into exactly outputSize
+// bytes. Fails on malformed input and on streams that decode to any other size, so a corrupt
+// or hostile archive cannot make the output grow past what its directory declared.
+// remaining, when given, receives the number of input bytes after the end of the stream.
+bool inflateRaw(QByteArrayView input, qsizetype outputSize, QByteArray *output, qsizetype *remaining = nullptr);
+
+// Decodes only the first outputSize bytes of a raw DEFLATE stream that is at least that long,
+// for callers that need the start of a large entry without inflating all of it.
+bool inflatePrefix(QByteArrayView input, qsizetype outputSize, QByteArray *output);
+
+// True when data starts with the gzip magic bytes.
+bool isGzip(QByteArrayView data);
+
+// Decodes a single-member gzip file (RFC 1952). The output size is taken from the trailer and
+// checked against what DEFLATE can expand the input to before anything is allocated.
+// Multi-member files and originals of 4 GiB or more are rejected. maxSize >= 0 decodes only
+// up to that many bytes from the start.
+bool gunzip(QByteArrayView input, QByteArray *output, qsizetype maxSize = -1);
+
+} // namespace Inflate
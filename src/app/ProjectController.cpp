@@ -84,6 +84,21 @@ bool ProjectController::addProject(const QString &name)
     return true;
 }
 
+void ProjectController::addProjects(const QStringList &names)
+{
+    QStringList list = m_model.stringList();
+    const qsizetype before = list.size();
+    for (const QString &name : names) {
+        const QString trimmed = name.trimmed();
+        if (!trimmed.isEmpty() && !list.contains(trimmed)) {
+            list.append(trimmed);
+        }
+    }
+    if (list.size() != before) {
+        m_model.setStringList(list);
+    }
+}
+
 bool ProjectController::renameProject(int index, const QString &name)
 {
     const QString trimmed = name.trimmed();
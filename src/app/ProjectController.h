@@ -20,6 +20,8 @@ public:
     QStringList allProjectNames() const;
     void setProjectNames(const QStringList &names, const QString &selected = QString());
     Q_INVOKABLE bool addProject(const QString &name);
+    // Adds the missing names in one list update and leaves the selection alone.
+    void addProjects(const QStringList &names);
     Q_INVOKABLE bool renameProject(int index, const QString &name);
     Q_INVOKABLE bool removeProject(int index);
     Q_INVOKABLE void clearSelection();
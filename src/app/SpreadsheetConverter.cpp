@@ -1,134 +1,143 @@
 #include "SpreadsheetConverter.h"
 #include "AppLogger.h"
+#include "AppPaths.h"
+#include "ConverterWorker.h"
+#include "ImportCache.h"
+#include "ImportTypes.h"
 
+#include <QDeadlineTimer>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QProcess>
-#include <QStandardPaths>
-
-#include <optional>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QUrl>
 
 namespace {
-struct PythonCommand {
-    QString program;
-    QStringList prefixArgs;
-};
+constexpr int ConverterTimeoutMs = 40000;
+constexpr int CancelPollMs = 100;
+// Office converters are heavy processes; batch imports run many conversions at once, so only
+// this many are started at a time. Each runs on a profile of its own (see below).
+constexpr int MaxConverterProcesses = 2;
 
-std::optional<PythonCommand> detectPythonCommand()
+QSemaphore &converterSlots()
 {
-    const QList<PythonCommand> candidates = {
-        {QStringLiteral("python3"), {}},
-        {QStringLiteral("python"), {}},
-        {QStringLiteral("py"), {QStringLiteral("-3")}}
-    };
-
-    for (const PythonCommand &candidate : candidates) {
-        QProcess check;
-        QStringList args = candidate.prefixArgs;
-        args.append(QStringLiteral("--version"));
-        check.start(candidate.program, args);
-        if (!check.waitForStarted(2500)) {
-            continue;
-        }
-        check.waitForFinished(4000);
-        if (check.exitStatus() == QProcess::NormalExit && check.exitCode() == 0) {
-            return candidate;
-        }
-    }
-    return std::nullopt;
+    static QSemaphore semaphore(MaxConverterProcesses);
+    return semaphore;
+}
 }
 
-bool runPythonInline(const QString &pythonCode, const QStringList &scriptArgs, QString *stdErr, QString *launchError)
+bool SpreadsheetConverter::toCsv(const QString &inputPath, QString *outputCsvPath, QString *error,
+                                 const ImportMonitor *monitor) const
 {
-    const std::optional<PythonCommand> python = detectPythonCommand();
-    if (!python.has_value()) {
-        if (launchError) {
-            *launchError = QStringLiteral("No Python interpreter found (tried: python3, python, py -3).");
+    if (inputPath.isEmpty()) {
+        if (error) {
+            *error = QStringLiteral("File path is empty.");
         }
         return false;
     }
 
-    QProcess process;
-    QStringList args = python->prefixArgs;
-    args << QStringLiteral("-c") << pythonCode;
-    args << scriptArgs;
-    process.start(python->program, args);
-    if (!process.waitForStarted(3000)) {
-        if (launchError) {
-            *launchError = QStringLiteral("Failed to launch Python command: %1 %2")
-                .arg(python->program, python->prefixArgs.join(' '));
+    // Compressed CSVs (.csv.gz) are inflated by the CSV parsers themselves.
+    if (inputPath.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)
+        || inputPath.endsWith(QStringLiteral(".gz"), Qt::CaseInsensitive)) {
+        if (outputCsvPath) {
+            *outputCsvPath = inputPath;
         }
-        return false;
+        return true;
     }
 
-    process.waitForFinished(45000);
-    const QString err = QString::fromUtf8(process.readAllStandardError()).trimmed();
-    if (stdErr) {
-        *stdErr = err;
-    }
-    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
-        if (launchError) {
-            *launchError = QStringLiteral("Python exited with code %1.").arg(process.exitCode());
-        }
-        return false;
-    }
-    return true;
-}
+    return convertSpreadsheetToCsv(inputPath, outputCsvPath, error, monitor);
 }
 
-bool SpreadsheetConverter::toCsv(const QString &inputPath, QString *outputCsvPath, QString *error) const
+bool SpreadsheetConverter::convertSpreadsheetToCsv(const QString &inputPath, QString *outputCsvPath, QString *error,
+                                                   const ImportMonitor *monitor) const
 {
-    if (inputPath.isEmpty()) {
+    const auto canceled = [&] {
+        if (monitor && monitor->isCanceled()) {
+            if (error) {
+                *error = QStringLiteral("Import canceled.");
+            }
+            return true;
+        }
+        return false;
+    };
+
+    // Outputs are named by the input's content hash, so the same workbook converts once per
+    // process however often (or from wherever) it is imported, and two different workbooks
+    // with the same file name never meet. Each conversion writes into a private work
+    // directory and its result is moved into place, so concurrent conversions cannot clash.
+    const ImportCache::Fingerprint source = ImportCache::fingerprint(inputPath);
+    if (!source.isValid()) {
         if (error) {
-            *error = QStringLiteral("File path is empty.");
+            *error = QStringLiteral("Cannot read file: %1").arg(inputPath);
         }
         return false;
     }
-
-    if (inputPath.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)) {
+    const QDir scratch(AppPaths::scratchDir());
+    const QString key = QString::number(source.contentHash, 16).rightJustified(16, QLatin1Char('0'));
+    const QString finalPath = scratch.filePath(key + QStringLiteral(".csv"));
+    if (QFile::exists(finalPath)) {
+        AppLogger::info(QStringLiteral("Reusing converted CSV: file=%1 csv=%2").arg(inputPath, finalPath));
         if (outputCsvPath) {
-            *outputCsvPath = inputPath;
+            *outputCsvPath = finalPath;
         }
         return true;
     }
 
-    return convertSpreadsheetToCsv(inputPath, outputCsvPath, error);
-}
-
-bool SpreadsheetConverter::convertSpreadsheetToCsv(const QString &inputPath, QString *outputCsvPath, QString *error) const
-{
-    const QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    if (tempDir.isEmpty()) {
+    const QTemporaryDir work(scratch.filePath(key + QStringLiteral("-XXXXXX")));
+    if (!work.isValid()) {
         if (error) {
-            *error = QStringLiteral("Cannot resolve temporary directory.");
+            *error = QStringLiteral("Cannot create scratch directory in %1.").arg(scratch.path());
         }
         return false;
     }
-
     const QFileInfo info(inputPath);
-    const QString outPath = QDir(tempDir).filePath(QStringLiteral("%1_link2bom.csv").arg(info.completeBaseName()));
+    const QString outPath = work.filePath(QStringLiteral("out.csv"));
+    // A concurrent conversion of the same content may have won the race; its output is as good.
+    const auto publish = [&](const QString &converted) {
+        if (!QFile::rename(converted, finalPath) && !QFile::exists(finalPath)) {
+            return false;
+        }
+        if (outputCsvPath) {
+            *outputCsvPath = finalPath;
+        }
+        return true;
+    };
 
+    // Workbooks are read in-process (XlsxReader, XlsReader) and only get here when that
+    // fails; for .xls that is usually a pre-97 BIFF version, which Python's xlrd still reads.
     QString pythonError;
-    if (info.suffix().compare(QStringLiteral("xlsx"), Qt::CaseInsensitive) == 0
-        || info.suffix().compare(QStringLiteral("xls"), Qt::CaseInsensitive) == 0) {
-        if (convertExcelToCsvWithPython(inputPath, outPath, &pythonError) && QFile::exists(outPath)) {
-            if (outputCsvPath) {
-                *outputCsvPath = outPath;
-            }
+    if (info.suffix().compare(QStringLiteral("xls"), Qt::CaseInsensitive) == 0) {
+        if (convertExcelToCsvWithPython(inputPath, outPath, &pythonError, monitor) && QFile::exists(outPath)
+            && publish(outPath)) {
             return true;
         }
         AppLogger::warn(QStringLiteral("Python conversion failed: %1").arg(pythonError));
     }
 
     auto runConverter = [&](const QString &program, const QStringList &args) -> bool {
+        while (!converterSlots().tryAcquire(1, CancelPollMs)) {
+            if (monitor && monitor->isCanceled()) {
+                return false;
+            }
+        }
+        const QSemaphoreReleaser slot(converterSlots());
         QProcess process;
         process.start(program, args);
         if (!process.waitForStarted(3000)) {
             AppLogger::warn(QStringLiteral("Converter start failed: %1 %2").arg(program, args.join(' ')));
             return false;
         }
-        process.waitForFinished(40000);
+        // Polled rather than one long wait, so a canceled import kills the converter at once.
+        const QDeadlineTimer deadline(ConverterTimeoutMs);
+        while (!process.waitForFinished(CancelPollMs) && process.state() != QProcess::NotRunning) {
+            if ((monitor && monitor->isCanceled()) || deadline.hasExpired()) {
+                process.kill();
+                process.waitForFinished(1000);
+                break;
+            }
+        }
         const bool ok = process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
         if (!ok) {
             AppLogger::warn(QStringLiteral("Converter failed: %1 exit=%2 stderr=%3")
@@ -141,31 +150,36 @@ bool SpreadsheetConverter::convertSpreadsheetToCsv(const QString &inputPath, QSt
 
     const QStringList officeCandidates {QStringLiteral("libreoffice"), QStringLiteral("soffice")};
     for (const QString &program : officeCandidates) {
+        if (canceled()) {
+            return false;
+        }
+        // Office instances sharing a user profile hand the job to whichever started first, or
+        // fail on its lock; a profile in the work directory keeps concurrent ones apart.
+        const QString profile = QUrl::fromLocalFile(work.filePath(QStringLiteral("profile"))).toString();
         const bool ok = runConverter(program,
-                                     {QStringLiteral("--headless"),
+                                     {QStringLiteral("-env:UserInstallation=") + profile,
+                                      QStringLiteral("--headless"),
                                       QStringLiteral("--convert-to"),
                                       QStringLiteral("csv:Text - txt - csv (StarCalc):44,34,76,1"),
                                       QStringLiteral("--outdir"),
-                                      QFileInfo(outPath).absolutePath(),
+                                      work.path(),
                                       inputPath});
-        if (ok) {
-            const QString converted = QDir(QFileInfo(outPath).absolutePath()).filePath(QStringLiteral("%1.csv").arg(info.completeBaseName()));
-            if (QFile::exists(converted)) {
-                if (outputCsvPath) {
-                    *outputCsvPath = converted;
-                }
-                return true;
-            }
+        const QString converted = work.filePath(QStringLiteral("%1.csv").arg(info.completeBaseName()));
+        if (ok && QFile::exists(converted) && publish(converted)) {
+            return true;
         }
     }
 
-    if (runConverter(QStringLiteral("ssconvert"), {inputPath, outPath}) && QFile::exists(outPath)) {
-        if (outputCsvPath) {
-            *outputCsvPath = outPath;
-        }
+    if (canceled()) {
+        return false;
+    }
+    if (runConverter(QStringLiteral("ssconvert"), {inputPath, outPath}) && QFile::exists(outPath) && publish(outPath)) {
         return true;
     }
 
+    if (canceled()) {
+        return false;
+    }
     if (error) {
         const QString fallback = QStringLiteral(
             "Import failed. No available converter worked (python/libreoffice/soffice/ssconvert).\n"
@@ -176,156 +190,33 @@ bool SpreadsheetConverter::convertSpreadsheetToCsv(const QString &inputPath, QSt
     return false;
 }
 
-bool SpreadsheetConverter::convertXlsxToCsvWithPython(const QString &inputPath, const QString &outputPath, QString *error) const
+bool SpreadsheetConverter::convertExcelToCsvWithPython(const QString &inputPath, const QString &outputPath, QString *error,
+                                                       const ImportMonitor *monitor) const
 {
-    const QString pythonCode = QStringLiteral(R"PY(
-import csv
-import sys
-import zipfile
-import xml.etree.ElementTree as ET
-
-in_path, out_path = sys.argv[1], sys.argv[2]
-ns = {'m': 'http://schemas.openxmlformats.org/spreadsheetml/2006/main'}
-
-with zipfile.ZipFile(in_path, 'r') as zf:
-    shared = []
-    if 'xl/sharedStrings.xml' in zf.namelist():
-        root = ET.fromstring(zf.read('xl/sharedStrings.xml'))
-        for si in root.findall('m:si', ns):
-            text = ''.join(t.text or '' for t in si.findall('.//m:t', ns))
-            shared.append(text)
-
-    sheet_name = 'xl/worksheets/sheet1.xml'
-    if sheet_name not in zf.namelist():
-        sheets = [n for n in zf.namelist() if n.startswith('xl/worksheets/sheet') and n.endswith('.xml')]
-        if not sheets:
-            raise RuntimeError('No worksheet found in xlsx file.')
-        sheet_name = sorted(sheets)[0]
-
-    root = ET.fromstring(zf.read(sheet_name))
-    rows = []
-    for row in root.findall('.//m:sheetData/m:row', ns):
-        cells = {}
-        max_col = -1
-        for c in row.findall('m:c', ns):
-            ref = c.attrib.get('r', '')
-            letters = ''.join(ch for ch in ref if ch.isalpha())
-            col = 0
-            for ch in letters:
-                col = col * 26 + (ord(ch.upper()) - 64)
-            col = max(col - 1, 0)
-            max_col = max(max_col, col)
-
-            t = c.attrib.get('t', '')
-            v = c.find('m:v', ns)
-            val = ''
-            if t == 'inlineStr':
-                it = c.find('m:is/m:t', ns)
-                if it is not None and it.text:
-                    val = it.text
-            elif t == 's' and v is not None and v.text and v.text.isdigit():
-                idx = int(v.text)
-                if 0 <= idx < len(shared):
-                    val = shared[idx]
-            elif v is not None and v.text:
-                val = v.text
-            cells[col] = val
-
-        if max_col >= 0:
-            line = [''] * (max_col + 1)
-            for k, v in cells.items():
-                line[k] = v
-            rows.append(line)
-
-with open(out_path, 'w', encoding='utf-8', newline='') as fp:
-    csv.writer(fp).writerows(rows)
-)PY");
-
-    QString stdErr;
-    QString launchError;
-    if (!runPythonInline(pythonCode, {inputPath, outputPath}, &stdErr, &launchError)) {
-        if (error) {
-            *error = QStringLiteral("Python is not available; cannot parse .xlsx in built-in mode. %1").arg(launchError);
-        }
-        AppLogger::warn(QStringLiteral("convertXlsxToCsvWithPython launch/run failed: %1, stderr=%2")
-                            .arg(launchError, stdErr));
-        return false;
-    }
-
-    const bool ok = QFile::exists(outputPath);
-    if (!ok && error) {
-        *error = stdErr.isEmpty()
-            ? QStringLiteral("Built-in .xlsx parsing failed.")
-            : QStringLiteral("Built-in .xlsx parsing failed: %1").arg(stdErr);
-    }
-    if (!ok) {
-        AppLogger::warn(QStringLiteral("convertXlsxToCsvWithPython output file missing: %1").arg(outputPath));
-    }
-    return ok;
-}
-
-bool SpreadsheetConverter::convertExcelToCsvWithPython(const QString &inputPath, const QString &outputPath, QString *error) const
-{
-    if (inputPath.endsWith(QStringLiteral(".xlsx"), Qt::CaseInsensitive)) {
-        return convertXlsxToCsvWithPython(inputPath, outputPath, error);
-    }
-
-    const QString pythonCode = QStringLiteral(R"PY(
-import csv
-import sys
-
-in_path, out_path = sys.argv[1], sys.argv[2]
-
-try:
-    import xlrd
-except Exception as exc:
-    raise RuntimeError(f"Missing 'xlrd' dependency for .xls parsing: {exc}")
-
-book = xlrd.open_workbook(in_path)
-if book.nsheets <= 0:
-    raise RuntimeError('No worksheet found in xls file.')
-
-sheet = book.sheet_by_index(0)
-rows = []
-for r in range(sheet.nrows):
-    line = []
-    for c in range(sheet.ncols):
-        cell = sheet.cell_value(r, c)
-        if isinstance(cell, float) and cell.is_integer():
-            line.append(str(int(cell)))
-        else:
-            line.append(str(cell))
-    rows.append(line)
-
-with open(out_path, 'w', encoding='utf-8', newline='') as fp:
-    csv.writer(fp).writerows(rows)
-)PY");
-
-    QString stdErr;
-    QString launchError;
-    if (!runPythonInline(pythonCode, {inputPath, outputPath}, &stdErr, &launchError)) {
+    QString workerError;
+    const ConverterWorker::Status status
+        = ConverterWorker::convert(QStringLiteral("xls"), inputPath, outputPath, &workerError, monitor);
+    if (status == ConverterWorker::Status::Unavailable) {
         if (error) {
-            *error = QStringLiteral("Python is not available; cannot parse .xls. %1").arg(launchError);
+            *error = QStringLiteral("Python is not available; cannot parse .xls. %1").arg(workerError);
         }
-        AppLogger::warn(QStringLiteral("convertExcelToCsvWithPython launch/run failed: %1, stderr=%2")
-                            .arg(launchError, stdErr));
+        AppLogger::warn(QStringLiteral("convertExcelToCsvWithPython launch failed: %1").arg(workerError));
         return false;
     }
 
-    const bool ok = QFile::exists(outputPath);
+    const bool ok = status == ConverterWorker::Status::Ok && QFile::exists(outputPath);
     if (!ok && error) {
-        const QString stderrMsg = stdErr;
-        if (stderrMsg.contains(QStringLiteral("xlrd"), Qt::CaseInsensitive)) {
+        if (workerError.contains(QStringLiteral("xlrd"), Qt::CaseInsensitive)) {
             *error = QStringLiteral(".xls import failed: missing Python package 'xlrd'. Run `python -m pip install xlrd`, or convert to .xlsx/.csv first.\n%1")
-                .arg(stderrMsg);
+                .arg(workerError);
         } else {
-            *error = stderrMsg.isEmpty()
+            *error = workerError.isEmpty()
                 ? QStringLiteral(".xls parsing failed.")
-                : QStringLiteral(".xls parsing failed: %1").arg(stderrMsg);
+                : QStringLiteral(".xls parsing failed: %1").arg(workerError);
         }
     }
     if (!ok) {
-        AppLogger::warn(QStringLiteral("convertExcelToCsvWithPython output file missing: %1").arg(outputPath));
+        AppLogger::warn(QStringLiteral("convertExcelToCsvWithPython failed: %1").arg(workerError));
     }
     return ok;
 }
@@ -2,13 +2,18 @@
 
 #include <QString>
 
+class ImportMonitor;
+
 class SpreadsheetConverter
 {
 public:
-    bool toCsv(const QString &inputPath, QString *outputCsvPath, QString *error) const;
+    // Canceling monitor kills whichever converter process is running and fails the call.
+    bool toCsv(const QString &inputPath, QString *outputCsvPath, QString *error,
+               const ImportMonitor *monitor = nullptr) const;
 
 private:
-    bool convertSpreadsheetToCsv(const QString &inputPath, QString *outputCsvPath, QString *error) const;
-    bool convertExcelToCsvWithPython(const QString &inputPath, const QString &outputPath, QString *error) const;
-    bool convertXlsxToCsvWithPython(const QString &inputPath, const QString &outputPath, QString *error) const;
+    bool convertSpreadsheetToCsv(const QString &inputPath, QString *outputCsvPath, QString *error,
+                                 const ImportMonitor *monitor) const;
+    bool convertExcelToCsvWithPython(const QString &inputPath, const QString &outputPath, QString *error,
+                                     const ImportMonitor *monitor) const;
 };
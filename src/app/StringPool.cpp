@@ -0,0 +1,77 @@
+#include "StringPool.h"
+
+#include <utility>
+
+StringPool::StringPool()
+{
+    insert(QStringView());
+}
+
+quint32 StringPool::intern(QStringView text)
+{
+    const quint32 id = insert(text);
+    m_entries[id].count += 1;
+    return id;
+}
+
+quint32 StringPool::find(QStringView text) const
+{
+    return m_ids.value(text, NoId);
+}
+
+void StringPool::clearCounts()
+{
+    for (Entry &entry : m_entries) {
+        entry.count = 0;
+    }
+}
+
+void StringPool::compact(QList<quint32> *remap)
+{
+    QList<bool> keep(m_entries.size(), false);
+    keep[EmptyId] = true;
+    for (const Entry &entry : std::as_const(m_entries)) {
+        if (entry.count > 0) {
+            keep[entry.trimmed] = true;
+        }
+    }
+    for (qsizetype id = 0; id < m_entries.size(); ++id) {
+        keep[id] = keep[id] || m_entries[id].count > 0;
+    }
+
+    remap->fill(NoId, m_entries.size());
+    QList<Entry> kept;
+    for (qsizetype id = 0; id < m_entries.size(); ++id) {
+        if (keep[id]) {
+            (*remap)[id] = quint32(kept.size());
+            kept.append(std::move(m_entries[id]));
+        }
+    }
+    for (Entry &entry : kept) {
+        entry.trimmed = (*remap)[entry.trimmed];
+    }
+
+    m_entries = std::move(kept);
+    m_ids.clear();
+    m_ids.reserve(m_entries.size());
+    for (qsizetype id = 0; id < m_entries.size(); ++id) {
+        m_ids.insert(QStringView(m_entries[id].text), quint32(id));
+    }
+}
+
+quint32 StringPool::insert(QStringView text)
+{
+    const auto it = m_ids.constFind(text);
+    if (it != m_ids.cend()) {
+        return it.value();
+    }
+
+    // The trimmed form goes in first so that its id is known; text that needs no trimming is
+    // its own trimmed form.
+    const QStringView trimmed = text.trimmed();
+    const quint32 trimmedId = trimmed.size() == text.size() ? quint32(m_entries.size()) : insert(trimmed);
+    const quint32 id = quint32(m_entries.size());
+    m_entries.append({text.toString(), trimmedId, 0});
+    m_ids.insert(QStringView(m_entries.last().text), id);
+    return id;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Dictionary of distinct strings, each with a 32-bit id and a count of the cells holding it.
+// BOM columns repeat a few hundred values over many rows, so a cell costs one id and equal
+// values compare, hash and group as integers. Every id also knows the id of its text with
+// surrounding whitespace removed, which is what filters and groupings compare. Not thread
+// safe; a parser keeps one per thread.
+class StringPool
+{
+public:
+    static constexpr quint32 EmptyId = 0;
+    static constexpr quint32 NoId = 0xFFFFFFFF;
+
+    StringPool();
+
+    // Returns the id of text, adding it if new, and counts one more use of it.
+    quint32 intern(QStringView text);
+    // The pooled copy of text, counted as one use. Cells decoded through this share their data.
+    const QString &share(QStringView text) { return string(intern(text)); }
+    // NoId when text was never added.
+    quint32 find(QStringView text) const;
+
+    const QString &string(quint32 id) const { return m_entries[id].text; }
+    quint32 trimmedId(quint32 id) const { return m_entries[id].trimmed; }
+    qint64 count(quint32 id) const { return m_entries[id].count; }
+    // Ids run from 0 to size() - 1.
+    int size() const { return int(m_entries.size()); }
+
+    // Sets every count to zero, for a caller about to recount its cells.
+    void clearCounts();
+    void addUses(quint32 id, qint64 uses) { m_entries[id].count += uses; }
+
+    // Drops every string with no uses that is not the trimmed form of one in use. remap
+    // receives the new id of each old id, or NoId for a dropped one.
+    void compact(QList<quint32> *remap);
+
+private:
+    struct Entry {
+        QString text;
+        quint32 trimmed = EmptyId;
+        qint64 count = 0;
+    };
+
+    quint32 insert(QStringView text);
+
+    QList<Entry> m_entries;
+    // Keys view the text of the entries, which stays in place while the list grows.
+    QHash<QStringView, quint32> m_ids;
+};
@@ -0,0 +1,102 @@
+#include "TrigramIndex.h"
+#include "StringPool.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// Three case-folded UTF-16 units packed into one key.
+template<typename Visit>
+void forEachTrigram(QStringView text, Visit visit)
+{
+    if (text.size() < TrigramIndex::MinNeedleLength) {
+        return;
+    }
+    quint64 window = (quint64(text[0].toCaseFolded().unicode()) << 16) | text[1].toCaseFolded().unicode();
+    for (qsizetype i = 2; i < text.size(); ++i) {
+        window = ((window << 16) | text[i].toCaseFolded().unicode()) & 0xFFFFFFFFFFFFull;
+        visit(window);
+    }
+}
+}
+
+void TrigramIndex::add(quint32 id, QStringView text)
+{
+    forEachTrigram(text, [this, id](quint64 trigram) {
+        std::vector<quint32> &posting = m_postings[trigram];
+        if (posting.empty() || posting.back() != id) {
+            posting.push_back(id);
+        }
+    });
+    m_count = id + 1;
+}
+
+void TrigramIndex::clear()
+{
+    m_postings.clear();
+    m_count = 0;
+}
+
+void TrigramIndex::remap(const QList<quint32> &remap)
+{
+    for (auto it = m_postings.begin(); it != m_postings.end();) {
+        std::vector<quint32> &posting = it.value();
+        auto out = posting.begin();
+        for (const quint32 id : posting) {
+            if (remap[id] != StringPool::NoId) {
+                *out++ = remap[id];
+            }
+        }
+        posting.erase(out, posting.end());
+        if (posting.empty()) {
+            it = m_postings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    quint32 count = 0;
+    for (quint32 id = 0; id < m_count; ++id) {
+        count += remap[id] != StringPool::NoId ? 1 : 0;
+    }
+    m_count = count;
+}
+
+bool TrigramIndex::candidates(QStringView needle, std::vector<quint32> *ids) const
+{
+    ids->clear();
+    // Characters outside the BMP fold as whole code points in QString::contains(), not unit by
+    // unit as here, so such needles are left to a plain scan.
+    if (needle.size() < MinNeedleLength
+        || std::any_of(needle.cbegin(), needle.cend(), [](QChar c) { return c.isSurrogate(); })) {
+        return false;
+    }
+
+    QList<const std::vector<quint32> *> postings;
+    bool missing = false;
+    forEachTrigram(needle, [this, &postings, &missing](quint64 trigram) {
+        const auto it = m_postings.constFind(trigram);
+        if (it == m_postings.cend()) {
+            missing = true;
+        } else {
+            postings.append(&it.value());
+        }
+    });
+    if (missing) {
+        return true;
+    }
+
+    // Shortest list first, so every merge is bounded by the smallest result so far.
+    std::sort(postings.begin(), postings.end(), [](const std::vector<quint32> *a, const std::vector<quint32> *b) {
+        return a->size() < b->size();
+    });
+    *ids = *postings.first();
+    std::vector<quint32> merged;
+    for (qsizetype i = 1; i < postings.size() && !ids->empty(); ++i) {
+        merged.clear();
+        std::set_intersection(ids->cbegin(), ids->cend(), postings[i]->cbegin(), postings[i]->cend(),
+                              std::back_inserter(merged));
+        ids->swap(merged);
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QStringView>
+
+#include <vector>
+
+// Inverted index from case-folded trigrams to the ids of the strings containing them, for
+// case-insensitive substring search over a string pool. Strings are added in id order, so
+// every posting list stays sorted and lookups intersect them by merging.
+class TrigramIndex
+{
+public:
+    // Needles shorter than this have no trigram to look up.
+    static constexpr int MinNeedleLength = 3;
+
+    // id must be indexedCount().
+    void add(quint32 id, QStringView text);
+    // Ids below this are indexed.
+    quint32 indexedCount() const { return m_count; }
+    void clear();
+
+    // Follows a compaction of the indexed ids: remap gives the new id of each old one, or
+    // StringPool::NoId for a dropped one, and must keep the kept ids in order.
+    void remap(const QList<quint32> &remap);
+
+    // Fills ids with every indexed string that may contain needle, ignoring case, in id order;
+    // callers still check each one. Returns false when the index cannot answer for needle (too
+    // short, or holding characters outside the BMP).
+    bool candidates(QStringView needle, std::vector<quint32> *ids) const;
+
+private:
+    QHash<quint64, std::vector<quint32>> m_postings;
+    quint32 m_count = 0;
+};
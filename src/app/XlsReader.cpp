@@ -0,0 +1,434 @@
+#include "XlsReader.h"
+#include "CompoundFile.h"
+
+#include <QLocale>
+#include <QMap>
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+constexpr quint16 RecordFormula = 0x0006;
+constexpr quint16 RecordEof = 0x000A;
+constexpr quint16 RecordFilePass = 0x002F;
+constexpr quint16 RecordContinue = 0x003C;
+constexpr quint16 RecordBoundSheet = 0x0085;
+constexpr quint16 RecordMulRk = 0x00BD;
+constexpr quint16 RecordSst = 0x00FC;
+constexpr quint16 RecordLabelSst = 0x00FD;
+constexpr quint16 RecordNumber = 0x0203;
+constexpr quint16 RecordLabel = 0x0204;
+constexpr quint16 RecordBoolErr = 0x0205;
+constexpr quint16 RecordString = 0x0207;
+constexpr quint16 RecordRk = 0x027E;
+constexpr quint16 RecordBof = 0x0809;
+constexpr quint16 Biff8Version = 0x0600;
+constexpr int MaxColumns = 256;
+constexpr int RowBlockSize = 32;
+
+struct Record {
+    quint16 type = 0;
+    QByteArrayView data;
+};
+
+quint16 read16(const char *p)
+{
+    const auto *u = reinterpret_cast<const uchar *>(p);
+    return quint16(u[0] | (u[1] << 8));
+}
+
+quint32 read32(const char *p)
+{
+    const auto *u = reinterpret_cast<const uchar *>(p);
+    return quint32(u[0]) | (quint32(u[1]) << 8) | (quint32(u[2]) << 16) | (quint32(u[3]) << 24);
+}
+
+double readDouble(const char *p)
+{
+    const quint64 bits = quint64(read32(p)) | (quint64(read32(p + 4)) << 32);
+    double value = 0;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+// Steps *pos over one record; false at the end of the stream or on a truncated record.
+bool nextRecord(QByteArrayView stream, qsizetype *pos, Record *record)
+{
+    if (*pos + 4 > stream.size()) {
+        return false;
+    }
+    const qsizetype length = read16(stream.data() + *pos + 2);
+    if (*pos + 4 + length > stream.size()) {
+        return false;
+    }
+    record->type = read16(stream.data() + *pos);
+    record->data = stream.sliced(*pos + 4, length);
+    *pos += 4 + length;
+    return true;
+}
+
+// BIFF8 stores characters either as UTF-16LE or "compressed" to their low byte (Latin-1).
+QString decodeChars(const char *p, qsizetype count, bool compressed)
+{
+    if (compressed) {
+        return QString::fromLatin1(p, count);
+    }
+    QString text(count, Qt::Uninitialized);
+    for (qsizetype i = 0; i < count; ++i) {
+        text[i] = QChar(read16(p + i * 2));
+    }
+    return text;
+}
+
+// XLUnicodeString (16-bit length, LABEL and STRING) or ShortXLUnicodeString (8-bit length,
+// BOUNDSHEET) inside a single record; formatting runs after the characters are ignored.
+QString readRecordString(QByteArrayView data, qsizetype offset, bool shortLength)
+{
+    const qsizetype lengthSize = shortLength ? 1 : 2;
+    if (offset + lengthSize + 1 > data.size()) {
+        return QString();
+    }
+    const qsizetype count = shortLength ? quint8(data[offset]) : read16(data.data() + offset);
+    const bool compressed = (quint8(data[offset + lengthSize]) & 0x01) == 0;
+    const qsizetype begin = offset + lengthSize + 1;
+    const qsizetype available = (data.size() - begin) / (compressed ? 1 : 2);
+    return decodeChars(data.data() + begin, qMin(count, available), compressed);
+}
+
+// Integral values are written without a fraction, the way the xlrd conversion did.
+QString formatNumber(double value)
+{
+    if (std::isfinite(value) && value == std::floor(value)) {
+        return std::fabs(value) < 1e18 ? QString::number(qint64(value)) : QString::number(value, 'f', 0);
+    }
+    return QString::number(value, 'g', QLocale::FloatingPointShortest);
+}
+
+// RK packs either a 30-bit integer or the top 30 bits of a double, optionally scaled by 100.
+double decodeRk(quint32 rk)
+{
+    double value = 0;
+    if (rk & 0x02) {
+        value = double(qint32(rk) >> 2);
+    } else {
+        const quint64 bits = quint64(rk & 0xFFFFFFFCu) << 32;
+        std::memcpy(&value, &bits, sizeof value);
+    }
+    return (rk & 0x01) ? value / 100.0 : value;
+}
+
+// Reads the SST body across its CONTINUE records. A string's characters may be split between
+// records; the continuation then restarts with an option byte that can switch between the
+// compressed and UTF-16 forms. Formatting runs and phonetic data may be split too, but
+// without an option byte.
+class SegmentReader
+{
+public:
+    explicit SegmentReader(QList<QByteArrayView> segments)
+        : m_segments(std::move(segments))
+    {
+    }
+
+    bool readByte(quint8 *value)
+    {
+        if (!ensureAvailable()) {
+            return false;
+        }
+        *value = quint8(m_segments[m_segment][m_pos++]);
+        return true;
+    }
+
+    bool read16(quint16 *value)
+    {
+        quint8 low = 0;
+        quint8 high = 0;
+        if (!readByte(&low) || !readByte(&high)) {
+            return false;
+        }
+        *value = quint16(low | (high << 8));
+        return true;
+    }
+
+    bool read32(quint32 *value)
+    {
+        quint16 low = 0;
+        quint16 high = 0;
+        if (!read16(&low) || !read16(&high)) {
+            return false;
+        }
+        *value = quint32(low) | (quint32(high) << 16);
+        return true;
+    }
+
+    bool skip(qint64 count)
+    {
+        while (count > 0) {
+            if (!ensureAvailable()) {
+                return false;
+            }
+            const qint64 step = qMin<qint64>(count, m_segments[m_segment].size() - m_pos);
+            m_pos += step;
+            count -= step;
+        }
+        return true;
+    }
+
+    bool readChars(qsizetype count, bool compressed, QString *text)
+    {
+        text->clear();
+        text->reserve(count);
+        while (count > 0) {
+            if (m_segment >= m_segments.size() || m_pos >= m_segments[m_segment].size()) {
+                quint8 options = 0;
+                if (!readByte(&options)) {
+                    return false;
+                }
+                compressed = (options & 0x01) == 0;
+            }
+            const QByteArrayView segment = m_segments[m_segment];
+            const qsizetype take = qMin(count, (segment.size() - m_pos) / (compressed ? 1 : 2));
+            if (take == 0) {
+                return false;
+            }
+            text->append(decodeChars(segment.data() + m_pos, take, compressed));
+            m_pos += take * (compressed ? 1 : 2);
+            count -= take;
+        }
+        return true;
+    }
+
+private:
+    bool ensureAvailable()
+    {
+        while (m_segment < m_segments.size() && m_pos >= m_segments[m_segment].size()) {
+            ++m_segment;
+            m_pos = 0;
+        }
+        return m_segment < m_segments.size();
+    }
+
+    QList<QByteArrayView> m_segments;
+    qsizetype m_segment = 0;
+    qsizetype m_pos = 0;
+};
+
+bool decodeSharedStrings(const QList<QByteArrayView> &segments, QStringList *strings)
+{
+    SegmentReader reader(segments);
+    quint32 total = 0;
+    quint32 unique = 0;
+    if (!reader.read32(&total) || !reader.read32(&unique)) {
+        return false;
+    }
+    strings->reserve(qMin<quint32>(unique, 1u << 20));
+    QString text;
+    for (quint32 i = 0; i < unique; ++i) {
+        quint16 count = 0;
+        quint8 options = 0;
+        quint16 runs = 0;
+        quint32 phoneticSize = 0;
+        if (!reader.read16(&count) || !reader.readByte(&options)
+            || ((options & 0x08) && !reader.read16(&runs))
+            || ((options & 0x04) && !reader.read32(&phoneticSize))
+            || !reader.readChars(count, (options & 0x01) == 0, &text)
+            || !reader.skip(qint64(runs) * 4 + phoneticSize)) {
+            return false;
+        }
+        strings->append(text);
+    }
+    return true;
+}
+} // namespace
+
+bool XlsReader::open(const QString &path, QString *error)
+{
+    m_stream.clear();
+    m_sheetNames.clear();
+    m_sheetOffsets.clear();
+    m_sharedStrings.clear();
+
+    CompoundFile file;
+    if (!file.open(path, error)) {
+        return false;
+    }
+    // Excel 5/95 workbooks name the stream "Book"; only the BIFF8 "Workbook" is read here.
+    if (!file.readStream(QStringLiteral("Workbook"), &m_stream, nullptr)) {
+        setError(error, QStringLiteral("No BIFF8 workbook stream in xls file (Excel 95 or older?): %1").arg(path));
+        return false;
+    }
+    return readGlobals(error);
+}
+
+bool XlsReader::readGlobals(QString *error)
+{
+    qsizetype pos = 0;
+    Record record;
+    if (!nextRecord(m_stream, &pos, &record) || record.type != RecordBof || record.data.size() < 2
+        || read16(record.data.data()) != Biff8Version) {
+        setError(error, QStringLiteral("Unsupported xls format: only BIFF8 (Excel 97-2003) workbooks can be read."));
+        return false;
+    }
+
+    while (nextRecord(m_stream, &pos, &record) && record.type != RecordEof) {
+        if (record.type == RecordFilePass) {
+            setError(error, QStringLiteral("The xls workbook is password-protected."));
+            return false;
+        }
+        if (record.type == RecordBoundSheet && record.data.size() >= 8) {
+            // Only worksheets; chart sheets and macro sheets have no cells to import.
+            if (quint8(record.data[5]) == 0x00) {
+                m_sheetOffsets.append(read32(record.data.data()));
+                m_sheetNames.append(readRecordString(record.data, 6, true));
+            }
+        } else if (record.type == RecordSst) {
+            QList<QByteArrayView> segments {record.data};
+            qsizetype next = pos;
+            Record continued;
+            while (nextRecord(m_stream, &next, &continued) && continued.type == RecordContinue) {
+                segments.append(continued.data);
+                pos = next;
+            }
+            if (!decodeSharedStrings(segments, &m_sharedStrings)) {
+                setError(error, QStringLiteral("Malformed shared strings in xls file."));
+                return false;
+            }
+        }
+    }
+
+    if (m_sheetOffsets.isEmpty()) {
+        setError(error, QStringLiteral("No worksheet found in xls file."));
+        return false;
+    }
+    return true;
+}
+
+bool XlsReader::readSheet(int index, QList<QStringList> *rows, QString *error, int maxRows) const
+{
+    if (index < 0 || index >= m_sheetOffsets.size()) {
+        setError(error, QStringLiteral("Worksheet index out of range: %1").arg(index));
+        return false;
+    }
+
+    qsizetype pos = m_sheetOffsets[index];
+    Record record;
+    if (!nextRecord(m_stream, &pos, &record) || record.type != RecordBof) {
+        setError(error, QStringLiteral("Malformed worksheet in xls file: %1").arg(m_sheetNames[index]));
+        return false;
+    }
+
+    // Cells arrive in row blocks but not strictly in order, so rows are collected by index.
+    QMap<int, QStringList> cells;
+    const auto setCell = [&cells](int row, int column, const QString &value) {
+        if (column >= MaxColumns) {
+            return;
+        }
+        QStringList &line = cells[row];
+        while (line.size() <= column) {
+            line.append(QString());
+        }
+        line[column] = value;
+    };
+
+    // Embedded charts bring their own BOF/EOF pairs inside the worksheet substream.
+    int depth = 1;
+    int pendingRow = -1;
+    int pendingColumn = -1;
+    while (depth > 0 && nextRecord(m_stream, &pos, &record)) {
+        // Row blocks hold at most 32 rows and follow each other in order, so once a full block
+        // past the limit has started the first maxRows rows are complete.
+        if (maxRows >= 0 && cells.size() >= qsizetype(maxRows) + RowBlockSize) {
+            break;
+        }
+        const QByteArrayView data = record.data;
+        if (record.type == RecordBof) {
+            ++depth;
+            continue;
+        }
+        if (record.type == RecordEof) {
+            --depth;
+            continue;
+        }
+        if (depth > 1) {
+            continue;
+        }
+        if (record.type == RecordString) {
+            if (pendingRow >= 0) {
+                setCell(pendingRow, pendingColumn, readRecordString(data, 0, false));
+                pendingRow = -1;
+            }
+            continue;
+        }
+        if (data.size() < 6) {
+            continue;
+        }
+        const int row = read16(data.data());
+        const int column = read16(data.data() + 2);
+
+        switch (record.type) {
+        case RecordLabelSst:
+            if (data.size() >= 10) {
+                const quint32 shared = read32(data.data() + 6);
+                setCell(row, column, shared < quint32(m_sharedStrings.size()) ? m_sharedStrings[shared] : QString());
+            }
+            break;
+        case RecordLabel:
+            setCell(row, column, readRecordString(data, 6, false));
+            break;
+        case RecordNumber:
+            if (data.size() >= 14) {
+                setCell(row, column, formatNumber(readDouble(data.data() + 6)));
+            }
+            break;
+        case RecordRk:
+            if (data.size() >= 10) {
+                setCell(row, column, formatNumber(decodeRk(read32(data.data() + 6))));
+            }
+            break;
+        case RecordMulRk: {
+            // row, first column, (xf, rk) per cell, last column.
+            const qsizetype count = (data.size() - 6) / 6;
+            for (qsizetype i = 0; i < count; ++i) {
+                setCell(row, column + int(i), formatNumber(decodeRk(read32(data.data() + 4 + i * 6 + 2))));
+            }
+            break;
+        }
+        case RecordBoolErr:
+            if (data.size() >= 8) {
+                setCell(row, column, QString::number(quint8(data[6])));
+            }
+            break;
+        case RecordFormula:
+            // The cached result is a double unless its top two bytes are 0xFFFF; a string
+            // result follows in the next STRING record.
+            if (data.size() >= 14) {
+                const char *result = data.data() + 6;
+                if (read16(result + 6) != 0xFFFF) {
+                    setCell(row, column, formatNumber(readDouble(result)));
+                } else if (result[0] == 0x00) {
+                    pendingRow = row;
+                    pendingColumn = column;
+                } else if (result[0] == 0x01 || result[0] == 0x02) {
+                    setCell(row, column, QString::number(quint8(result[2])));
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    rows->clear();
+    rows->reserve(cells.size());
+    for (auto it = cells.cbegin(); it != cells.cend() && (maxRows < 0 || rows->size() < maxRows); ++it) {
+        rows->append(it.value());
+    }
+    return true;
+}
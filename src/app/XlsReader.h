@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Reads BIFF8 (Excel 97-2003) .xls worksheets in-process as rows of cell text, with the same
+// shape as XlsxReader. The Workbook stream is pulled out of the OLE2 container once; the
+// shared-string table (SST and its CONTINUE records) is decoded up front and each worksheet
+// is read from its BOUNDSHEET offset. Numbers come out the way the xlrd conversion wrote
+// them: integral values without a fraction, others in shortest round-trip form.
+class XlsReader
+{
+public:
+    bool open(const QString &path, QString *error);
+
+    QStringList sheetNames() const { return m_sheetNames; }
+    // maxRows >= 0 stops reading the sheet soon after that many rows.
+    bool readSheet(int index, QList<QStringList> *rows, QString *error, int maxRows = -1) const;
+
+private:
+    bool readGlobals(QString *error);
+
+    QByteArray m_stream;
+    QStringList m_sheetNames;
+    QList<quint32> m_sheetOffsets;
+    QStringList m_sharedStrings;
+};
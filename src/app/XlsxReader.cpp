@@ -0,0 +1,258 @@
+#include "XlsxReader.h"
+
+#include <QDir>
+#include <QHash>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+const QString WorkbookPart = QStringLiteral("xl/workbook.xml");
+const QString WorkbookRelsPart = QStringLiteral("xl/_rels/workbook.xml.rels");
+const QString DefaultSharedStringsPart = QStringLiteral("xl/sharedStrings.xml");
+// Inflated bytes tried first when only the leading rows of a worksheet are wanted.
+constexpr qint64 PrefixBudget = 256 * 1024;
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+// Relationship targets are relative to xl/ unless they start at the package root.
+QString resolvePart(const QString &target)
+{
+    if (target.startsWith(QLatin1Char('/'))) {
+        return QDir::cleanPath(target.mid(1));
+    }
+    return QDir::cleanPath(QStringLiteral("xl/") + target);
+}
+
+// "AB12" -> 27; -1 when the reference has no column letters or more than a sheet allows (XFD).
+int columnOfReference(QStringView reference)
+{
+    int column = 0;
+    int letters = 0;
+    for (const QChar ch : reference) {
+        const char16_t c = ch.unicode();
+        const char16_t upper = (c >= u'a' && c <= u'z') ? char16_t(c - u'a' + u'A') : c;
+        if (upper < u'A' || upper > u'Z') {
+            break;
+        }
+        if (++letters > 3) {
+            return -1;
+        }
+        column = column * 26 + (upper - u'A' + 1);
+    }
+    return letters > 0 ? column - 1 : -1;
+}
+
+// Concatenates the <t> runs of a shared or inline string, leaving out phonetic hints (<rPh>).
+QString readRichText(QXmlStreamReader &xml)
+{
+    QString text;
+    const QString end = xml.name().toString();
+    while (!xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::StartElement) {
+            if (xml.name() == u"t") {
+                text += xml.readElementText();
+            } else if (xml.name() == u"rPh") {
+                xml.skipCurrentElement();
+            }
+        } else if (token == QXmlStreamReader::EndElement && xml.name() == end) {
+            break;
+        }
+    }
+    return text;
+}
+} // namespace
+
+bool XlsxReader::open(const QString &path, QString *error)
+{
+    m_sheetNames.clear();
+    m_sheetParts.clear();
+    m_sharedStrings.clear();
+    return m_zip.open(path, error) && readWorkbook(error);
+}
+
+bool XlsxReader::readWorkbook(QString *error)
+{
+    QHash<QString, QString> relTargets;
+    QString sharedStringsPart = DefaultSharedStringsPart;
+
+    QByteArray data;
+    if (m_zip.contains(WorkbookRelsPart) && m_zip.read(WorkbookRelsPart, &data, error)) {
+        QXmlStreamReader xml(data);
+        while (!xml.atEnd()) {
+            if (xml.readNext() != QXmlStreamReader::StartElement || xml.name() != u"Relationship") {
+                continue;
+            }
+            const QXmlStreamAttributes attributes = xml.attributes();
+            const QString target = resolvePart(attributes.value(u"Target").toString());
+            relTargets.insert(attributes.value(u"Id").toString(), target);
+            if (attributes.value(u"Type").endsWith(u"/sharedStrings")) {
+                sharedStringsPart = target;
+            }
+        }
+    }
+
+    if (m_zip.contains(WorkbookPart) && m_zip.read(WorkbookPart, &data, error)) {
+        QXmlStreamReader xml(data);
+        while (!xml.atEnd()) {
+            if (xml.readNext() != QXmlStreamReader::StartElement || xml.name() != u"sheet") {
+                continue;
+            }
+            QString relId;
+            const QXmlStreamAttributes attributes = xml.attributes();
+            for (const QXmlStreamAttribute &attribute : attributes) {
+                if (attribute.name() == u"id" && !attribute.namespaceUri().isEmpty()) {
+                    relId = attribute.value().toString();
+                }
+            }
+            const QString part = relTargets.value(relId);
+            if (!part.isEmpty() && m_zip.contains(part)) {
+                m_sheetNames.append(attributes.value(u"name").toString());
+                m_sheetParts.append(part);
+            }
+        }
+    }
+
+    // Workbooks written without relationships still name their sheets sheetN.xml.
+    if (m_sheetParts.isEmpty()) {
+        const QStringList names = m_zip.entryNames();
+        for (const QString &name : names) {
+            if (name.startsWith(QStringLiteral("xl/worksheets/sheet")) && name.endsWith(QStringLiteral(".xml"))) {
+                m_sheetParts.append(name);
+            }
+        }
+        std::sort(m_sheetParts.begin(), m_sheetParts.end(), [](const QString &a, const QString &b) {
+            return a.size() != b.size() ? a.size() < b.size() : a < b;
+        });
+        for (const QString &part : std::as_const(m_sheetParts)) {
+            m_sheetNames.append(part.mid(14, part.size() - 14 - 4));
+        }
+    }
+
+    if (m_sheetParts.isEmpty()) {
+        setError(error, QStringLiteral("No worksheet found in xlsx file."));
+        return false;
+    }
+
+    return !m_zip.contains(sharedStringsPart) || readSharedStrings(sharedStringsPart, error);
+}
+
+bool XlsxReader::readSharedStrings(const QString &partName, QString *error)
+{
+    QByteArray data;
+    if (!m_zip.read(partName, &data, error)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(data);
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        if (xml.name() == u"sst") {
+            m_sharedStrings.reserve(xml.attributes().value(u"uniqueCount").toInt());
+        } else if (xml.name() == u"si") {
+            m_sharedStrings.append(readRichText(xml));
+        }
+    }
+    if (xml.hasError()) {
+        setError(error, QStringLiteral("Malformed shared strings in xlsx file: %1").arg(xml.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool XlsxReader::readSheet(int index, QList<QStringList> *rows, QString *error, int maxRows) const
+{
+    if (index < 0 || index >= m_sheetParts.size()) {
+        setError(error, QStringLiteral("Worksheet index out of range: %1").arg(index));
+        return false;
+    }
+
+    // With a row limit only a prefix of the part is inflated, grown until it holds maxRows
+    // rows or is the whole part.
+    qint64 budget = maxRows >= 0 ? PrefixBudget : -1;
+    for (;;) {
+        QByteArray data;
+        bool complete = true;
+        if (!m_zip.readPrefix(m_sheetParts[index], budget, &data, &complete, error)) {
+            return false;
+        }
+        QString message;
+        const QXmlStreamReader::Error xmlError = parseRows(data, maxRows, rows, &message);
+        if (xmlError == QXmlStreamReader::NoError) {
+            return true;
+        }
+        // A prefix may end anywhere, even inside a UTF-8 sequence, so any error there only
+        // means more of the part is needed.
+        if (complete) {
+            setError(error, QStringLiteral("Malformed worksheet in xlsx file: %1").arg(message));
+            return false;
+        }
+        budget *= 4;
+    }
+}
+
+QXmlStreamReader::Error XlsxReader::parseRows(const QByteArray &data, int maxRows, QList<QStringList> *rows,
+                                              QString *message) const
+{
+    rows->clear();
+    QStringList row;
+    bool rowHasCells = false;
+    int column = -1;
+    QString type;
+    QString value;
+
+    QXmlStreamReader xml(data);
+    while (!xml.atEnd() && (maxRows < 0 || rows->size() < maxRows)) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::StartElement) {
+            const QStringView name = xml.name();
+            if (name == u"row") {
+                row.clear();
+                rowHasCells = false;
+                column = -1;
+            } else if (name == u"c") {
+                const QXmlStreamAttributes attributes = xml.attributes();
+                const int referenced = columnOfReference(attributes.value(u"r"));
+                column = referenced >= 0 ? referenced : column + 1;
+                type = attributes.value(u"t").toString();
+                value.clear();
+            } else if (name == u"v") {
+                value = xml.readElementText();
+            } else if (name == u"is") {
+                value = readRichText(xml);
+            } else if (name == u"f" || name == u"extLst") {
+                xml.skipCurrentElement();
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            const QStringView name = xml.name();
+            if (name == u"c") {
+                if (type == QLatin1String("s")) {
+                    bool ok = false;
+                    const int shared = value.toInt(&ok);
+                    value = ok && shared >= 0 && shared < m_sharedStrings.size() ? m_sharedStrings[shared] : QString();
+                }
+                while (row.size() <= column) {
+                    row.append(QString());
+                }
+                row[column] = value;
+                rowHasCells = true;
+            } else if (name == u"row" && rowHasCells) {
+                rows->append(row);
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        *message = xml.errorString();
+    }
+    return xml.error();
+}
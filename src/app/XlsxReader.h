@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QXmlStreamReader>
+
+#include "ZipArchive.h"
+
+// Reads .xlsx worksheets in-process as rows of cell text. The shared-strings table is decoded
+// once per workbook; cells referring to it share its strings instead of copying them. Values
+// come out as stored (numbers unformatted, booleans as 0/1), matching what the CSV import of
+// a converted workbook used to see.
+class XlsxReader
+{
+public:
+    bool open(const QString &path, QString *error);
+
+    QStringList sheetNames() const { return m_sheetNames; }
+    // maxRows >= 0 stops after that many rows and inflates only as much of the sheet as they need.
+    bool readSheet(int index, QList<QStringList> *rows, QString *error, int maxRows = -1) const;
+
+private:
+    bool readWorkbook(QString *error);
+    QXmlStreamReader::Error parseRows(const QByteArray &data, int maxRows, QList<QStringList> *rows,
+                                      QString *message) const;
+    bool readSharedStrings(const QString &partName, QString *error);
+
+    ZipArchive m_zip;
+    QStringList m_sheetNames;
+    QStringList m_sheetParts;
+    QStringList m_sharedStrings;
+};
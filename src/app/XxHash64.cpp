@@ -0,0 +1,130 @@
+#include "XxHash64.h"
+
+#include <cstring>
+
+namespace {
+constexpr quint64 Prime1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 Prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 Prime3 = 0x165667B19E3779F9ULL;
+constexpr quint64 Prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 Prime5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 rotl(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian loads regardless of host order, so digests match other implementations.
+inline quint64 load64(const uchar *p)
+{
+    quint64 value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+inline quint32 load32(const uchar *p)
+{
+    return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24);
+}
+
+inline quint64 round(quint64 lane, quint64 input)
+{
+    lane += input * Prime2;
+    lane = rotl(lane, 31);
+    return lane * Prime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 lane)
+{
+    acc ^= round(0, lane);
+    return acc * Prime1 + Prime4;
+}
+} // namespace
+
+XxHash64::XxHash64(quint64 seed)
+    : m_seed(seed)
+{
+    m_lanes[0] = seed + Prime1 + Prime2;
+    m_lanes[1] = seed + Prime2;
+    m_lanes[2] = seed;
+    m_lanes[3] = seed - Prime1;
+}
+
+void XxHash64::add(QByteArrayView data)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data.data());
+    const uchar *const end = p + data.size();
+    m_totalLength += quint64(data.size());
+
+    if (m_buffered + data.size() < 32) {
+        std::memcpy(m_buffer + m_buffered, p, size_t(data.size()));
+        m_buffered += int(data.size());
+        return;
+    }
+
+    if (m_buffered > 0) {
+        const int fill = 32 - m_buffered;
+        std::memcpy(m_buffer + m_buffered, p, size_t(fill));
+        for (int i = 0; i < 4; ++i) {
+            m_lanes[i] = round(m_lanes[i], load64(m_buffer + i * 8));
+        }
+        p += fill;
+        m_buffered = 0;
+    }
+
+    for (; end - p >= 32; p += 32) {
+        m_lanes[0] = round(m_lanes[0], load64(p));
+        m_lanes[1] = round(m_lanes[1], load64(p + 8));
+        m_lanes[2] = round(m_lanes[2], load64(p + 16));
+        m_lanes[3] = round(m_lanes[3], load64(p + 24));
+    }
+
+    m_buffered = int(end - p);
+    std::memcpy(m_buffer, p, size_t(m_buffered));
+}
+
+quint64 XxHash64::digest() const
+{
+    quint64 acc;
+    if (m_totalLength >= 32) {
+        acc = rotl(m_lanes[0], 1) + rotl(m_lanes[1], 7) + rotl(m_lanes[2], 12) + rotl(m_lanes[3], 18);
+        for (const quint64 lane : m_lanes) {
+            acc = mergeRound(acc, lane);
+        }
+    } else {
+        acc = m_seed + Prime5;
+    }
+    acc += m_totalLength;
+
+    const uchar *p = m_buffer;
+    const uchar *const end = m_buffer + m_buffered;
+    for (; end - p >= 8; p += 8) {
+        acc ^= round(0, load64(p));
+        acc = rotl(acc, 27) * Prime1 + Prime4;
+    }
+    if (end - p >= 4) {
+        acc ^= quint64(load32(p)) * Prime1;
+        acc = rotl(acc, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        acc ^= quint64(*p) * Prime5;
+        acc = rotl(acc, 11) * Prime1;
+    }
+
+    acc ^= acc >> 33;
+    acc *= Prime2;
+    acc ^= acc >> 29;
+    acc *= Prime3;
+    acc ^= acc >> 32;
+    return acc;
+}
+
+quint64 XxHash64::hash(QByteArrayView data, quint64 seed)
+{
+    XxHash64 state(seed);
+    state.add(data);
+    return state.digest();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QByteArrayView>
+
+// Streaming XXH64 (the reference algorithm, seed 0 by default). Used to fingerprint file
+// contents, where it runs at memory bandwidth and is far cheaper than re-importing.
+class XxHash64
+{
+public:
+    explicit XxHash64(quint64 seed = 0);
+
+    void add(QByteArrayView data);
+    quint64 digest() const;
+
+    static quint64 hash(QByteArrayView data, quint64 seed = 0);
+
+private:
+    quint64 m_seed = 0;
+    quint64 m_lanes[4] = {};
+    quint64 m_totalLength = 0;
+    uchar m_buffer[32] = {};
+    int m_buffered = 0;
+};
@@ -0,0 +1,178 @@
+#include "ZipArchive.h"
+
+#include "Inflate.h"
+
+namespace {
+constexpr quint32 LocalHeaderSignature = 0x04034b50;
+constexpr quint32 CentralHeaderSignature = 0x02014b50;
+constexpr quint32 EndOfDirectorySignature = 0x06054b50;
+constexpr qsizetype LocalHeaderSize = 30;
+constexpr qsizetype CentralHeaderSize = 46;
+constexpr qsizetype EndOfDirectorySize = 22;
+constexpr qsizetype MaxCommentSize = 0xFFFF;
+constexpr quint16 Stored = 0;
+constexpr quint16 Deflated = 8;
+constexpr quint16 EncryptedFlag = 0x0001;
+constexpr quint16 Utf8NameFlag = 0x0800;
+
+quint16 read16(const char *p)
+{
+    const auto *u = reinterpret_cast<const uchar *>(p);
+    return quint16(u[0] | (u[1] << 8));
+}
+
+quint32 read32(const char *p)
+{
+    const auto *u = reinterpret_cast<const uchar *>(p);
+    return quint32(u[0]) | (quint32(u[1]) << 8) | (quint32(u[2]) << 16) | (quint32(u[3]) << 24);
+}
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+} // namespace
+
+bool ZipArchive::open(const QString &path, QString *error)
+{
+    m_entries.clear();
+    m_data = QByteArrayView();
+    m_buffer.clear();
+    m_file.close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        setError(error, QStringLiteral("Cannot open archive: %1").arg(path));
+        return false;
+    }
+    if (const uchar *mapped = m_file.size() > 0 ? m_file.map(0, m_file.size()) : nullptr) {
+        m_data = QByteArrayView(reinterpret_cast<const char *>(mapped), m_file.size());
+    } else {
+        m_buffer = m_file.readAll();
+        m_data = m_buffer;
+    }
+
+    // The end-of-directory record sits before an optional trailing comment of up to 64 KiB.
+    qsizetype end = -1;
+    const qsizetype lowest = qMax<qsizetype>(0, m_data.size() - EndOfDirectorySize - MaxCommentSize);
+    for (qsizetype pos = m_data.size() - EndOfDirectorySize; pos >= lowest; --pos) {
+        if (read32(m_data.data() + pos) == EndOfDirectorySignature) {
+            end = pos;
+            break;
+        }
+    }
+    if (end < 0) {
+        setError(error, QStringLiteral("Not a ZIP archive: %1").arg(path));
+        return false;
+    }
+
+    const char *eocd = m_data.data() + end;
+    const quint16 entryCount = read16(eocd + 10);
+    const quint32 directorySize = read32(eocd + 12);
+    const quint32 directoryOffset = read32(eocd + 16);
+    if (entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFFu) {
+        setError(error, QStringLiteral("ZIP64 archives are not supported: %1").arg(path));
+        return false;
+    }
+    if (qint64(directoryOffset) + directorySize > end) {
+        setError(error, QStringLiteral("Corrupt ZIP directory: %1").arg(path));
+        return false;
+    }
+
+    qsizetype pos = directoryOffset;
+    m_entries.reserve(entryCount);
+    for (int i = 0; i < entryCount; ++i) {
+        if (pos + CentralHeaderSize > end || read32(m_data.data() + pos) != CentralHeaderSignature) {
+            setError(error, QStringLiteral("Corrupt ZIP directory: %1").arg(path));
+            m_entries.clear();
+            return false;
+        }
+        const char *header = m_data.data() + pos;
+        const quint16 flags = read16(header + 8);
+        const quint16 nameLength = read16(header + 28);
+        const quint16 extraLength = read16(header + 30);
+        const quint16 commentLength = read16(header + 32);
+        if (pos + CentralHeaderSize + nameLength > end) {
+            setError(error, QStringLiteral("Corrupt ZIP directory: %1").arg(path));
+            m_entries.clear();
+            return false;
+        }
+
+        const QByteArrayView rawName(header + CentralHeaderSize, nameLength);
+        const QString name = (flags & Utf8NameFlag) ? QString::fromUtf8(rawName) : QString::fromLatin1(rawName);
+        // Encrypted entries are skipped; callers see them as missing.
+        if (!(flags & EncryptedFlag)) {
+            Entry entry;
+            entry.method = read16(header + 10);
+            entry.compressedSize = read32(header + 20);
+            entry.size = read32(header + 24);
+            entry.localHeaderOffset = read32(header + 42);
+            m_entries.insert(name, entry);
+        }
+        pos += CentralHeaderSize + nameLength + extraLength + commentLength;
+    }
+    return true;
+}
+
+bool ZipArchive::read(const QString &name, QByteArray *data, QString *error) const
+{
+    return readPrefix(name, -1, data, nullptr, error);
+}
+
+bool ZipArchive::readPrefix(const QString &name, qint64 maxSize, QByteArray *data, bool *complete,
+                            QString *error) const
+{
+    const auto it = m_entries.constFind(name);
+    if (it == m_entries.cend()) {
+        setError(error, QStringLiteral("Archive entry not found: %1").arg(name));
+        return false;
+    }
+    const Entry &entry = it.value();
+
+    // The local header repeats the name and may carry a different extra field, so only its
+    // lengths are taken from it; sizes come from the central directory.
+    const qint64 headerPos = entry.localHeaderOffset;
+    if (headerPos + LocalHeaderSize > m_data.size() || read32(m_data.data() + headerPos) != LocalHeaderSignature) {
+        setError(error, QStringLiteral("Corrupt archive entry: %1").arg(name));
+        return false;
+    }
+    const qint64 dataPos = headerPos + LocalHeaderSize + read16(m_data.data() + headerPos + 26)
+        + read16(m_data.data() + headerPos + 28);
+    if (dataPos + entry.compressedSize > m_data.size()) {
+        setError(error, QStringLiteral("Corrupt archive entry: %1").arg(name));
+        return false;
+    }
+    const QByteArrayView compressed = m_data.sliced(dataPos, entry.compressedSize);
+    const qint64 size = maxSize >= 0 && maxSize < entry.size ? maxSize : entry.size;
+    if (complete) {
+        *complete = size == entry.size;
+    }
+
+    switch (entry.method) {
+    case Stored:
+        if (entry.compressedSize != entry.size) {
+            setError(error, QStringLiteral("Corrupt archive entry: %1").arg(name));
+            return false;
+        }
+        *data = compressed.first(size).toByteArray();
+        return true;
+    case Deflated:
+        // The declared size sizes the output buffer, so a claim DEFLATE cannot reach is refused
+        // before anything is allocated.
+        if (!Inflate::withinExpansionBound(entry.size, entry.compressedSize)) {
+            setError(error, QStringLiteral("Corrupt archive entry: %1").arg(name));
+            return false;
+        }
+        if (!(size == entry.size ? Inflate::inflateRaw(compressed, size, data)
+                                 : Inflate::inflatePrefix(compressed, size, data))) {
+            setError(error, QStringLiteral("Corrupt compressed data in archive entry: %1").arg(name));
+            return false;
+        }
+        return true;
+    default:
+        setError(error, QStringLiteral("Unsupported compression method %1 in archive entry: %2").arg(entry.method).arg(name));
+        return false;
+    }
+}
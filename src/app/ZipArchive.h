@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+// Read-only ZIP container (stored and deflated entries, no ZIP64 or encryption), enough for
+// OOXML workbooks. The archive is mapped and entries are located through the central
+// directory, so reading one part never touches the others.
+class ZipArchive
+{
+public:
+    bool open(const QString &path, QString *error);
+
+    bool contains(const QString &name) const { return m_entries.contains(name); }
+    QStringList entryNames() const { return m_entries.keys(); }
+    bool read(const QString &name, QByteArray *data, QString *error) const;
+    // Reads at most maxSize bytes from the start of the entry, inflating no more than that;
+    // *complete tells whether that was the whole entry.
+    bool readPrefix(const QString &name, qint64 maxSize, QByteArray *data, bool *complete, QString *error) const;
+
+private:
+    struct Entry {
+        quint16 method = 0;
+        qint64 compressedSize = 0;
+        qint64 size = 0;
+        qint64 localHeaderOffset = 0;
+    };
+
+    QFile m_file;
+    QByteArray m_buffer;
+    QByteArrayView m_data;
+    QHash<QString, Entry> m_entries;
+};
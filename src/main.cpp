@@ -14,6 +14,7 @@
 
 #include "app/AppController.h"
 #include "app/AppLogger.h"
+#include "app/AppPaths.h"
 
 #ifdef Q_OS_WIN
 #ifndef DWMWA_USE_IMMERSIVE_DARK_MODE
@@ -56,6 +57,7 @@ int main(int argc, char *argv[])
     QCoreApplication::setOrganizationName(QStringLiteral("Link2BOM"));
     QCoreApplication::setApplicationName(QStringLiteral("Link2BOM"));
     AppLogger::initialize();
+    AppPaths::removeStaleScratchDirs();
 
     AppController controller;
 
@@ -4,6 +4,7 @@ var textZh = {
     "dialog.selectImportProject": "选择导入项目",
     "dialog.newProjectOr": "或新建项目",
     "dialog.selectLichuangFile": "选择立创导出文件",
+    "dialog.linkFile": "关联文件（变更时自动增量导入）",
     "dialog.selectExportCsvFile": "选择导出 CSV 文件",
     "dialog.inputName": "请输入名称",
     "dialog.newProject": "新建项目",
@@ -21,6 +22,15 @@ var textZh = {
     "common.clear": "清空",
     "common.ok": "确定",
     "common.cancel": "取消",
+    "import.cancel": "取消导入",
+    "import.rowsParsed": "已解析行数：",
+    "preview.title": "导入预览",
+    "preview.columns": "列映射",
+    "preview.rows": "前几行",
+    "preview.import": "导入",
+    "preview.failed": "无法预览：",
+    "preview.mismatch": "表头与当前 BOM 视图不一致，导入将被拒绝。",
+    "preview.replace": "表头与当前 BOM 视图不同，导入后将替换表头。",
     "diff.title": "差异分析",
     "diff.todo": "后续接入版本对比、替代料推荐、成本变化趋势。",
     "diff.search.placeholder": "搜索差异（关键料号/字段/值）",
@@ -101,6 +111,7 @@ var textEn = {
     "dialog.selectImportProject": "Select Import Project",
     "dialog.newProjectOr": "Or create new project",
     "dialog.selectLichuangFile": "Select LCSC export file",
+    "dialog.linkFile": "Link file (re-import changes automatically)",
     "dialog.selectExportCsvFile": "Select CSV export file",
     "dialog.inputName": "Please enter a name",
     "dialog.newProject": "New Project",
@@ -118,6 +129,15 @@ var textEn = {
     "common.clear": "Clear",
     "common.ok": "OK",
     "common.cancel": "Cancel",
+    "import.cancel": "Cancel import",
+    "import.rowsParsed": "Rows parsed: ",
+    "preview.title": "Import Preview",
+    "preview.columns": "Columns",
+    "preview.rows": "First rows",
+    "preview.import": "Import",
+    "preview.failed": "No preview: ",
+    "preview.mismatch": "Headers do not match the current BOM view; the import will be refused.",
+    "preview.replace": "Headers differ from the current BOM view; they will be replaced.",
     "diff.title": "Diff Analysis",
     "diff.todo": "Version diff, alternates suggestion, and cost trend will be added later.",
     "diff.search.placeholder": "Search diffs (key part/field/value)",
@@ -169,6 +169,16 @@ ApplicationWindow {
     palette.placeholderText: mutedTextColor
     palette.mid: borderColor
 
+    // Keystrokes in the BOM search only reach the model once typing pauses.
+    Timer {
+        id: bomSearchDebounce
+        interval: 150
+        onTriggered: {
+            root.appCtx.bomModel.setFilterKeyword(root.bomSearchText)
+            root.logInfo("Global BOM search changed: \"" + root.bomSearchText + "\"")
+        }
+    }
+
     DialogHost {
         id: dialogHost
         anchors.fill: parent
@@ -261,6 +271,11 @@ ApplicationWindow {
                 root.refreshDiffAnalysis()
             }
         }
+        function onLayoutChanged() {
+            if (root.activeTabIndex === 1) {
+                root.refreshDiffAnalysis()
+            }
+        }
         function onHeaderDataChanged() {
             if (root.activeTabIndex === 1) {
                 root.refreshDiffAnalysis()
@@ -382,7 +397,11 @@ ApplicationWindow {
                     textMap: root.textMap
                     currentIndex: root.activeTabIndex
                     searchText: root.activeTabIndex === 0 ? root.bomSearchText : root.diffSearchText
+                    importing: root.appCtx.io.importing
+                    importProgress: root.appCtx.io.importProgress
+                    importRows: root.appCtx.io.importRowsParsed
                     onToggleDebugRequested: root.debugPanelVisible = !root.debugPanelVisible
+                    onCancelImportRequested: root.appCtx.io.cancelImport()
                     onTabChanged: function(index) {
                         root.syncingTopSearch = true
                         root.activeTabIndex = index
@@ -398,8 +417,7 @@ ApplicationWindow {
                         }
                         if (root.activeTabIndex === 0) {
                             root.bomSearchText = text
-                            root.appCtx.bomModel.setFilterKeyword(text)
-                            root.logInfo("Global BOM search changed: \"" + text + "\"")
+                            bomSearchDebounce.restart()
                         } else {
                             root.diffSearchText = text
                             root.refreshDiffAnalysis()
@@ -409,6 +427,7 @@ ApplicationWindow {
                     onClearRequested: {
                         if (root.activeTabIndex === 0) {
                             root.bomSearchText = ""
+                            bomSearchDebounce.stop()
                             root.appCtx.bomModel.setFilterKeyword("")
                             root.logInfo("Global BOM search cleared")
                         } else {
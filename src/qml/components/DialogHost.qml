@@ -101,6 +101,9 @@ Item {
 
     property string activeProjectForImport: ""
     property string importMode: "lcsc"
+    property bool linkImport: false
+    property url pendingImportFile
+    property var importPreview: ({})
     property var archiveSlots: []
     property int activeArchiveIndex: 0
     property var projectOptions: []
@@ -166,6 +169,14 @@ Item {
                 }
             }
 
+            CheckBox {
+                id: linkImportCheck
+                visible: importMode === "lcsc"
+                text: root.txSafe("dialog.linkFile", "Link file (re-import changes automatically)")
+                font.pixelSize: 13
+                checked: false
+            }
+
             RowLayout {
                 Layout.fillWidth: true
                 DialogFooter {
@@ -185,6 +196,7 @@ Item {
                             root.app.projects.addProject(created)
                         }
                         root.activeProjectForImport = target
+                        root.linkImport = importMode === "lcsc" && linkImportCheck.checked
                         fileDialog.open()
                         newProjectField.clear()
                         projectForImportDialog.close()
@@ -199,12 +211,148 @@ Item {
         title: importMode === "lcsc"
             ? root.txSafe("dialog.selectLichuangFile", "Select LCSC export file")
             : root.txSafe("dialog.selectGenericFile", "Select spreadsheet file")
-        nameFilters: ["Spreadsheet Files (*.xlsx *.xls *.csv)", "All Files (*.*)"]
+        // Several files at once are imported as a batch, each into a project named after it.
+        fileMode: root.linkImport ? FileDialog.OpenFile : FileDialog.OpenFiles
+        nameFilters: ["Spreadsheet Files (*.xlsx *.xls *.csv *.csv.gz *.zip)", "All Files (*.*)"]
         onAccepted: {
-            if (importMode === "lcsc") {
-                root.app.io.importLichuang(selectedFile, root.activeProjectForImport)
-            } else {
-                root.app.io.importGeneric(selectedFile, root.activeProjectForImport)
+            if (!root.linkImport && selectedFiles.length > 1) {
+                root.app.io.importBatch(selectedFiles, importMode === "lcsc")
+                return
+            }
+            root.pendingImportFile = selectedFile
+            root.importPreview = root.app.io.previewImport(selectedFile, importMode === "lcsc", root.activeProjectForImport)
+            importPreviewDialog.open()
+        }
+    }
+
+    function startPendingImport() {
+        if (importMode === "lcsc" && root.linkImport) {
+            root.app.io.linkLichuang(root.pendingImportFile, root.activeProjectForImport)
+        } else if (importMode === "lcsc") {
+            root.app.io.importLichuang(root.pendingImportFile, root.activeProjectForImport)
+        } else {
+            root.app.io.importGeneric(root.pendingImportFile, root.activeProjectForImport)
+        }
+    }
+
+    function previewNotice() {
+        const preview = root.importPreview
+        if (!preview.ok) {
+            return root.txSafe("preview.failed", "No preview: ") + preview.error
+        }
+        if (!preview.fitsView) {
+            return importMode === "lcsc"
+                ? root.txSafe("preview.mismatch", "Headers do not match the current BOM view; the import will be refused.")
+                : root.txSafe("preview.replace", "Headers differ from the current BOM view; they will be replaced.")
+        }
+        return ""
+    }
+
+    ModalShell {
+        id: importPreviewDialog
+        width: Math.min(root.width - 40, 760)
+        implicitHeight: previewContent.implicitHeight + 20
+        x: Math.round((root.width - width) / 2)
+        y: Math.round((root.height - height) / 2)
+        parent: Overlay.overlay
+        subtleColor: root.subtleColor
+        borderColor: root.borderColor
+
+        ColumnLayout {
+            id: previewContent
+            anchors.fill: parent
+            spacing: 10
+
+            Label {
+                text: root.txSafe("preview.title", "Import Preview")
+                color: root.textColor
+                font.bold: true
+            }
+
+            Label {
+                Layout.fillWidth: true
+                visible: text.length > 0
+                text: root.previewNotice()
+                color: root.primaryColor
+                wrapMode: Text.Wrap
+            }
+
+            Label {
+                Layout.fillWidth: true
+                visible: root.importPreview.ok === true
+                text: root.txSafe("preview.columns", "Columns")
+                color: root.mutedTextColor
+                font.pixelSize: 12
+            }
+
+            Flow {
+                Layout.fillWidth: true
+                visible: root.importPreview.ok === true
+                spacing: 6
+
+                Repeater {
+                    model: root.importPreview.headers || []
+
+                    delegate: Rectangle {
+                        required property string modelData
+                        required property int index
+                        readonly property string source: (root.importPreview.sourceHeaders || [])[index] || ""
+                        radius: 8
+                        color: root.cardColor
+                        border.color: source.length > 0 ? root.borderColor : root.primaryColor
+                        implicitWidth: columnLabel.implicitWidth + 16
+                        implicitHeight: columnLabel.implicitHeight + 8
+
+                        Text {
+                            id: columnLabel
+                            anchors.centerIn: parent
+                            text: parent.source.length > 0 && parent.source !== parent.modelData
+                                ? parent.modelData + " \u2190 " + parent.source
+                                : parent.modelData
+                            color: root.textColor
+                            font.pixelSize: 12
+                        }
+                    }
+                }
+            }
+
+            Label {
+                Layout.fillWidth: true
+                visible: root.importPreview.ok === true
+                text: root.txSafe("preview.rows", "First rows")
+                color: root.mutedTextColor
+                font.pixelSize: 12
+            }
+
+            ListView {
+                Layout.fillWidth: true
+                Layout.preferredHeight: 220
+                visible: root.importPreview.ok === true
+                clip: true
+                model: root.importPreview.rows || []
+                ScrollBar.vertical: ScrollBar {}
+
+                delegate: Text {
+                    required property var modelData
+                    width: ListView.view.width
+                    text: modelData.join("  |  ")
+                    color: root.textColor
+                    font.pixelSize: 12
+                    elide: Text.ElideRight
+                    padding: 2
+                }
+            }
+
+            DialogFooter {
+                Layout.fillWidth: true
+                themeColors: root.themeColors
+                cancelText: root.txSafe("common.cancel", "Cancel")
+                okText: root.txSafe("preview.import", "Import")
+                onCancelled: importPreviewDialog.close()
+                onAccepted: {
+                    importPreviewDialog.close()
+                    root.startPendingImport()
+                }
             }
         }
     }
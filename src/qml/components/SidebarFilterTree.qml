@@ -107,6 +107,7 @@ Item {
     Connections {
         target: root.app.bomModel
         function onModelReset() { root.refreshCategoryBuckets() }
+        function onLayoutChanged() { root.refreshCategoryBuckets() }
         function onHeaderDataChanged() { root.refreshCategoryBuckets() }
     }
 
@@ -12,10 +12,15 @@ Item {
     required property var textMap
     property int currentIndex: 0
     property string searchText: ""
+    property bool importing: false
+    // -1 while the import cannot tell how far it is (a converter is running).
+    property real importProgress: -1
+    property real importRows: 0
     signal tabChanged(int index)
     signal searchEdited(string text)
     signal clearRequested()
     signal toggleDebugRequested()
+    signal cancelImportRequested()
 
     function txSafe(key, fallback) {
         if (root.textMap && root.textMap[key] !== undefined) {
@@ -142,6 +147,38 @@ Item {
             }
         }
 
+        ColumnLayout {
+            visible: root.importing
+            Layout.preferredWidth: 150
+            spacing: 2
+
+            ProgressBar {
+                Layout.fillWidth: true
+                from: 0
+                to: 1
+                indeterminate: root.importProgress < 0
+                value: Math.max(0, root.importProgress)
+            }
+
+            Text {
+                Layout.fillWidth: true
+                text: root.txSafe("import.rowsParsed", "Rows parsed: ") + root.importRows
+                color: root.mutedTextColor
+                font.pixelSize: 11
+                elide: Text.ElideRight
+            }
+        }
+
+        AppButton {
+            visible: root.importing
+            themeColors: root.themeColors
+            text: root.txSafe("import.cancel", "Cancel import")
+            font.pixelSize: 14
+            cornerRadius: 10
+            implicitHeight: 42
+            onClicked: root.cancelImportRequested()
+        }
+
         AppButton {
             themeColors: root.themeColors
             text: root.txSafe("common.clear", "Clear")